@@ -1,20 +1,65 @@
 #include "bitmap.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cstddef>
+#include <utility>
 
+#include "bitmapview.h"
+#include "pixelformat.h"
 #include "rgba.h"
 
 namespace geometrize
 {
 
-Bitmap::Bitmap(const std::uint32_t width, const std::uint32_t height, const geometrize::rgba color) : m_width{width}, m_height{height}, m_data(width * height * 4U)
+Bitmap::Bitmap(const std::uint32_t width, const std::uint32_t height, const geometrize::rgba color) :
+    Bitmap(width, height, color, geometrize::PixelFormat::RGBA8888)
+{}
+
+Bitmap::Bitmap(const std::uint32_t width, const std::uint32_t height, const geometrize::rgba color, const geometrize::PixelFormat format) :
+    m_width{width}, m_height{height}, m_format{format}, m_data(static_cast<std::size_t>(width) * height * getBytesPerPixel(format))
 {
+    assert(format == geometrize::PixelFormat::RGBA8888 || format == geometrize::PixelFormat::GRAY8);
     fill(color);
 }
 
-Bitmap::Bitmap(const std::uint32_t width, const std::uint32_t height, const std::vector<std::uint8_t>& data) : m_width{width}, m_height{height}, m_data{data}
+Bitmap::Bitmap(const std::uint32_t width, const std::uint32_t height, const std::vector<std::uint8_t>& data) :
+    Bitmap(width, height, data, geometrize::PixelFormat::RGBA8888)
+{}
+
+Bitmap::Bitmap(const std::uint32_t width, const std::uint32_t height, const std::vector<std::uint8_t>& data, const geometrize::PixelFormat format) :
+    m_width{width}, m_height{height}, m_format{format}, m_data{data}
+{
+    assert(format == geometrize::PixelFormat::RGBA8888 || format == geometrize::PixelFormat::GRAY8);
+    assert((static_cast<std::size_t>(width) * height * getBytesPerPixel(format)) == data.size());
+}
+
+Bitmap::Bitmap(const std::uint32_t width, const std::uint32_t height, std::vector<std::uint8_t>&& data) :
+    Bitmap(width, height, std::move(data), geometrize::PixelFormat::RGBA8888)
+{}
+
+Bitmap::Bitmap(const std::uint32_t width, const std::uint32_t height, std::vector<std::uint8_t>&& data, const geometrize::PixelFormat format) :
+    m_width{width}, m_height{height}, m_format{format}, m_data{std::move(data)}
+{
+    assert(format == geometrize::PixelFormat::RGBA8888 || format == geometrize::PixelFormat::GRAY8);
+    assert((static_cast<std::size_t>(width) * height * getBytesPerPixel(format)) == m_data.size());
+}
+
+Bitmap::Bitmap(const geometrize::BitmapView& view) : Bitmap(view, geometrize::PixelFormat::RGBA8888)
+{}
+
+Bitmap::Bitmap(const geometrize::BitmapView& view, const geometrize::PixelFormat format) :
+    m_width{view.getWidth()}, m_height{view.getHeight()}, m_format{format}, m_data(static_cast<std::size_t>(view.getWidth()) * view.getHeight() * getBytesPerPixel(format))
 {
-    assert((width * height * 4U) == data.size());
+    assert(format == geometrize::PixelFormat::RGBA8888 || format == geometrize::PixelFormat::GRAY8);
+    const std::size_t rowBytes{static_cast<std::size_t>(m_width) * getBytesPerPixel(format)};
+    for(std::uint32_t y = 0; y < m_height; y++) {
+        if(format == geometrize::PixelFormat::GRAY8) {
+            view.copyGrayRow(y, m_data.data() + y * rowBytes);
+        } else {
+            view.copyRow(y, m_data.data() + y * rowBytes);
+        }
+    }
 }
 
 std::uint32_t Bitmap::getWidth() const
@@ -27,6 +72,11 @@ std::uint32_t Bitmap::getHeight() const
     return m_height;
 }
 
+geometrize::PixelFormat Bitmap::getFormat() const
+{
+    return m_format;
+}
+
 std::vector<std::uint8_t> Bitmap::copyData() const
 {
     return m_data;
@@ -37,23 +87,46 @@ const std::vector<std::uint8_t>& Bitmap::getDataRef() const
     return m_data;
 }
 
+std::vector<std::uint8_t>& Bitmap::getDataRef()
+{
+    return m_data;
+}
+
 geometrize::rgba Bitmap::getPixel(const std::uint32_t x, const std::uint32_t y) const
 {
-    const std::size_t index{(m_width * y + x) * 4U};
+    if(m_format == geometrize::PixelFormat::GRAY8) {
+        const std::uint8_t value{m_data[getPixelIndex(m_width, x, y)]};
+        return geometrize::rgba{value, value, value, UINT8_MAX};
+    }
+    const std::size_t index{getPixelIndex(m_width, x, y) * 4U};
     return geometrize::rgba{m_data[index], m_data[index + 1U], m_data[index + 2U], m_data[index + 3U]};
 }
 
 void Bitmap::setPixel(const std::uint32_t x, const std::uint32_t y, const geometrize::rgba color)
 {
-    const std::uint32_t index{(m_width * y + x) * 4U};
+    if(m_format == geometrize::PixelFormat::GRAY8) {
+        m_data[getPixelIndex(m_width, x, y)] = geometrize::luminance(color);
+        return;
+    }
+    const std::size_t index{getPixelIndex(m_width, x, y) * 4U};
     m_data[index] = color.r;
     m_data[index + 1U] = color.g;
     m_data[index + 2U] = color.b;
     m_data[index + 3U] = color.a;
 }
 
+std::size_t Bitmap::getPixelIndex(const std::uint32_t width, const std::uint32_t x, const std::uint32_t y)
+{
+    // The index is worked out in size_t, since the pixel count of large images does not fit in 32 bits
+    return static_cast<std::size_t>(width) * y + x;
+}
+
 void Bitmap::fill(const geometrize::rgba color)
 {
+    if(m_format == geometrize::PixelFormat::GRAY8) {
+        std::fill(m_data.begin(), m_data.end(), geometrize::luminance(color));
+        return;
+    }
     for(std::size_t i = 0; i < m_data.size(); i += 4U) {
         m_data[i] = color.r;
         m_data[i + 1U] = color.g;
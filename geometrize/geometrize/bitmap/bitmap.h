@@ -1,15 +1,24 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <vector>
 
+#include "pixelformat.h"
 #include "rgba.h"
 
+namespace geometrize
+{
+class BitmapView;
+}
+
 namespace geometrize
 {
 
 /**
  * @brief The Bitmap class is a helper class for working with bitmap data.
+ * Bitmaps hold RGBA8888 pixels by default. GRAY8 bitmaps hold a single luminance byte per pixel, and read as opaque gray RGBA colors.
+ * Models created with a GRAY8 target work on a quarter of the data, see geometrize::Model.
  * @author Sam Twidale (http://samcodes.co.uk/)
  */
 class Bitmap
@@ -23,6 +32,15 @@ public:
      */
     Bitmap(std::uint32_t width, std::uint32_t height, geometrize::rgba color);
 
+    /**
+     * @brief Bitmap Creates a new bitmap in the given format.
+     * @param width The width of the bitmap.
+     * @param height The height of the bitmap.
+     * @param color The starting color of the bitmap (RGBA format), converted to the luminance for GRAY8 bitmaps.
+     * @param format The format of the bitmap, RGBA8888 or GRAY8.
+     */
+    Bitmap(std::uint32_t width, std::uint32_t height, geometrize::rgba color, geometrize::PixelFormat format);
+
     /**
      * @brief Bitmap Creates a new bitmap from the supplied byte data.
      * @param width The width of the bitmap.
@@ -31,9 +49,51 @@ public:
      */
     Bitmap(std::uint32_t width, std::uint32_t height, const std::vector<std::uint8_t>& data);
 
+    /**
+     * @brief Bitmap Creates a new bitmap in the given format from the supplied byte data.
+     * @param width The width of the bitmap.
+     * @param height The height of the bitmap.
+     * @param data The byte data to fill the bitmap with, must be width * height * bytes per pixel long.
+     * @param format The format of the bitmap, RGBA8888 or GRAY8.
+     */
+    Bitmap(std::uint32_t width, std::uint32_t height, const std::vector<std::uint8_t>& data, geometrize::PixelFormat format);
+
+    /**
+     * @brief Bitmap Creates a new bitmap that takes ownership of the supplied byte data, without copying it.
+     * @param width The width of the bitmap.
+     * @param height The height of the bitmap.
+     * @param data The byte data of the bitmap, must be width * height * depth (4) long.
+     */
+    Bitmap(std::uint32_t width, std::uint32_t height, std::vector<std::uint8_t>&& data);
+
+    /**
+     * @brief Bitmap Creates a new bitmap in the given format that takes ownership of the supplied byte data, without copying it.
+     * @param width The width of the bitmap.
+     * @param height The height of the bitmap.
+     * @param data The byte data of the bitmap, must be width * height * bytes per pixel long.
+     * @param format The format of the bitmap, RGBA8888 or GRAY8.
+     */
+    Bitmap(std::uint32_t width, std::uint32_t height, std::vector<std::uint8_t>&& data, geometrize::PixelFormat format);
+
+    /**
+     * @brief Bitmap Creates a new bitmap from a view of pixel data, converting the pixels to RGBA8888 and dropping any row padding in a single pass.
+     * @param view The view of the pixel data to copy.
+     */
+    explicit Bitmap(const geometrize::BitmapView& view);
+
+    /**
+     * @brief Bitmap Creates a new bitmap in the given format from a view of pixel data, converting the pixels and dropping any row padding in a single pass.
+     * Color pixels are converted to their luminance for GRAY8 bitmaps, see geometrize::luminance.
+     * @param view The view of the pixel data to copy.
+     * @param format The format of the bitmap, RGBA8888 or GRAY8.
+     */
+    Bitmap(const geometrize::BitmapView& view, geometrize::PixelFormat format);
+
     ~Bitmap() = default;
     Bitmap& operator=(const geometrize::Bitmap&) = default;
     Bitmap(const geometrize::Bitmap&) = default;
+    Bitmap& operator=(geometrize::Bitmap&&) = default;
+    Bitmap(geometrize::Bitmap&&) = default;
 
     /**
      * @brief getWidth Gets the width of the bitmap.
@@ -45,6 +105,11 @@ public:
      */
     std::uint32_t getHeight() const;
 
+    /**
+     * @brief getFormat Gets the format of the bitmap, RGBA8888 or GRAY8.
+     */
+    geometrize::PixelFormat getFormat() const;
+
     /**
      * @brief copyData Gets a copy of the raw bitmap data.
      * @return The bitmap data.
@@ -57,11 +122,17 @@ public:
      */
     const std::vector<std::uint8_t>& getDataRef() const;
 
+    /**
+     * @brief getDataRef Gets a reference to the raw bitmap data, for modifying the pixels directly.
+     * @return The bitmap data.
+     */
+    std::vector<std::uint8_t>& getDataRef();
+
     /**
      * @brief getPixel Gets a pixel color value.
      * @param x The x-coordinate of the pixel.
      * @param y The y-coordinate of the pixel.
-     * @return The pixel RGBA color value.
+     * @return The pixel RGBA color value, opaque gray for GRAY8 bitmaps.
      */
     geometrize::rgba getPixel(std::uint32_t x, std::uint32_t y) const;
 
@@ -69,19 +140,31 @@ public:
      * @brief setPixel Sets a pixel color value.
      * @param x The x-coordinate of the pixel.
      * @param y The y-coordinate of the pixel.
-     * @param color The pixel RGBA color value.
+     * @param color The pixel RGBA color value, converted to the luminance for GRAY8 bitmaps.
      */
     void setPixel(std::uint32_t x, std::uint32_t y, geometrize::rgba color);
 
     /**
      * @brief fill Fills the bitmap with the given color.
-     * @param color The color to fill the bitmap with.
+     * @param color The color to fill the bitmap with, converted to the luminance for GRAY8 bitmaps.
      */
     void fill(geometrize::rgba color);
 
+    /**
+     * @brief getPixelIndex Gets the index of a pixel in a bitmap, counting pixels rather than bytes from the start of the bitmap.
+     * The index is worked out in std::size_t, so it is correct for bitmaps with more than UINT32_MAX pixels.
+     * @param width The width of the bitmap.
+     * @param x The x-coordinate of the pixel.
+     * @param y The y-coordinate of the pixel.
+     * @return The index of the pixel.
+     */
+    static std::size_t getPixelIndex(std::uint32_t width, std::uint32_t x, std::uint32_t y);
+
 private:
+
     std::uint32_t m_width; ///< The width of the bitmap.
     std::uint32_t m_height; ///< The height of the bitmap.
+    geometrize::PixelFormat m_format; ///< The format of the bitmap.
     std::vector<std::uint8_t> m_data; ///< The bitmap data.
 };
 
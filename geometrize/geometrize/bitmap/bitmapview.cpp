@@ -0,0 +1,120 @@
+#include "bitmapview.h"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "rgba.h"
+
+namespace geometrize
+{
+
+BitmapView::BitmapView(const std::uint8_t* const data, const std::uint32_t width, const std::uint32_t height) :
+    BitmapView(data, width, height, static_cast<std::size_t>(width) * 4U, geometrize::PixelFormat::RGBA8888)
+{}
+
+BitmapView::BitmapView(const std::uint8_t* const data, const std::uint32_t width, const std::uint32_t height, const std::size_t stride, const geometrize::PixelFormat format) :
+    m_data{data}, m_width{width}, m_height{height}, m_stride{stride}, m_format{format}
+{
+    assert(stride >= width * getBytesPerPixel(format));
+    assert(data != nullptr || width == 0 || height == 0);
+}
+
+const std::uint8_t* BitmapView::getData() const
+{
+    return m_data;
+}
+
+std::uint32_t BitmapView::getWidth() const
+{
+    return m_width;
+}
+
+std::uint32_t BitmapView::getHeight() const
+{
+    return m_height;
+}
+
+std::size_t BitmapView::getStride() const
+{
+    return m_stride;
+}
+
+geometrize::PixelFormat BitmapView::getFormat() const
+{
+    return m_format;
+}
+
+std::size_t BitmapView::getRowOffset(const std::uint32_t y) const
+{
+    return static_cast<std::size_t>(y) * m_stride;
+}
+
+const std::uint8_t* BitmapView::getRow(const std::uint32_t y) const
+{
+    return m_data + getRowOffset(y);
+}
+
+geometrize::rgba BitmapView::getPixel(const std::uint32_t x, const std::uint32_t y) const
+{
+    const std::uint8_t* pixel{getRow(y) + x * getBytesPerPixel(m_format)};
+    switch(m_format) {
+    case geometrize::PixelFormat::BGRA8888:
+        return geometrize::rgba{pixel[2], pixel[1], pixel[0], pixel[3]};
+    case geometrize::PixelFormat::RGB888:
+        return geometrize::rgba{pixel[0], pixel[1], pixel[2], UINT8_MAX};
+    case geometrize::PixelFormat::GRAY8:
+        return geometrize::rgba{pixel[0], pixel[0], pixel[0], UINT8_MAX};
+    default:
+        return geometrize::rgba{pixel[0], pixel[1], pixel[2], pixel[3]};
+    }
+}
+
+void BitmapView::copyRow(const std::uint32_t y, std::uint8_t* const destination) const
+{
+    const std::uint8_t* source{getRow(y)};
+    const std::size_t width{m_width};
+    switch(m_format) {
+    case geometrize::PixelFormat::BGRA8888:
+        for(std::size_t x = 0; x < width; x++) {
+            destination[x * 4U] = source[x * 4U + 2U];
+            destination[x * 4U + 1U] = source[x * 4U + 1U];
+            destination[x * 4U + 2U] = source[x * 4U];
+            destination[x * 4U + 3U] = source[x * 4U + 3U];
+        }
+        break;
+    case geometrize::PixelFormat::RGB888:
+        for(std::size_t x = 0; x < width; x++) {
+            destination[x * 4U] = source[x * 3U];
+            destination[x * 4U + 1U] = source[x * 3U + 1U];
+            destination[x * 4U + 2U] = source[x * 3U + 2U];
+            destination[x * 4U + 3U] = UINT8_MAX;
+        }
+        break;
+    case geometrize::PixelFormat::GRAY8:
+        for(std::size_t x = 0; x < width; x++) {
+            destination[x * 4U] = source[x];
+            destination[x * 4U + 1U] = source[x];
+            destination[x * 4U + 2U] = source[x];
+            destination[x * 4U + 3U] = UINT8_MAX;
+        }
+        break;
+    default:
+        std::memcpy(destination, source, width * 4U);
+        break;
+    }
+}
+
+void BitmapView::copyGrayRow(const std::uint32_t y, std::uint8_t* const destination) const
+{
+    if(m_format == geometrize::PixelFormat::GRAY8) {
+        std::memcpy(destination, getRow(y), m_width);
+        return;
+    }
+    for(std::uint32_t x = 0; x < m_width; x++) {
+        destination[x] = geometrize::luminance(getPixel(x, y));
+    }
+}
+
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "pixelformat.h"
+#include "rgba.h"
+
+namespace geometrize
+{
+
+/**
+ * @brief The BitmapView class is a read-only view of pixel data owned by someone else, such as a frame held by an image decoder.
+ * The rows may be padded and the pixels may be in any of the layouts in geometrize::PixelFormat. The data must outlive the view.
+ * A geometrize::Bitmap can be created from a view, which converts the pixels to the bitmap's format in a single pass.
+ * @author Sam Twidale (http://samcodes.co.uk/)
+ */
+class BitmapView
+{
+public:
+    /**
+     * @brief BitmapView Creates a view of tightly packed RGBA8888 pixel data.
+     * @param data The pixel data, must be at least width * height * 4 bytes long.
+     * @param width The width of the bitmap.
+     * @param height The height of the bitmap.
+     */
+    BitmapView(const std::uint8_t* data, std::uint32_t width, std::uint32_t height);
+
+    /**
+     * @brief BitmapView Creates a view of pixel data.
+     * @param data The pixel data, must be at least stride * (height - 1) + width * bytes per pixel long.
+     * @param width The width of the bitmap.
+     * @param height The height of the bitmap.
+     * @param stride The number of bytes from the start of one row to the start of the next, at least width * bytes per pixel.
+     * @param format The layout of the pixels.
+     */
+    BitmapView(const std::uint8_t* data, std::uint32_t width, std::uint32_t height, std::size_t stride, geometrize::PixelFormat format);
+
+    ~BitmapView() = default;
+    BitmapView& operator=(const geometrize::BitmapView&) = default;
+    BitmapView(const geometrize::BitmapView&) = default;
+
+    /**
+     * @brief getData Gets the pixel data.
+     */
+    const std::uint8_t* getData() const;
+
+    /**
+     * @brief getWidth Gets the width of the bitmap.
+     */
+    std::uint32_t getWidth() const;
+
+    /**
+     * @brief getHeight Gets the height of the bitmap.
+     */
+    std::uint32_t getHeight() const;
+
+    /**
+     * @brief getStride Gets the number of bytes from the start of one row to the start of the next.
+     */
+    std::size_t getStride() const;
+
+    /**
+     * @brief getFormat Gets the layout of the pixels.
+     */
+    geometrize::PixelFormat getFormat() const;
+
+    /**
+     * @brief getRowOffset Gets the offset of the start of a row from the start of the pixel data, in bytes.
+     * The offset is worked out in std::size_t, so it is correct for pixel data over 4 GiB.
+     * @param y The y-coordinate of the row.
+     * @return The offset of the start of the row.
+     */
+    std::size_t getRowOffset(std::uint32_t y) const;
+
+    /**
+     * @brief getRow Gets the start of a row of pixel data.
+     * @param y The y-coordinate of the row.
+     * @return The start of the row.
+     */
+    const std::uint8_t* getRow(std::uint32_t y) const;
+
+    /**
+     * @brief getPixel Gets a pixel color value, converted to RGBA.
+     * @param x The x-coordinate of the pixel.
+     * @param y The y-coordinate of the pixel.
+     * @return The pixel RGBA color value.
+     */
+    geometrize::rgba getPixel(std::uint32_t x, std::uint32_t y) const;
+
+    /**
+     * @brief copyRow Converts a row of pixels to RGBA8888.
+     * @param y The y-coordinate of the row.
+     * @param destination Where to write the converted row, must be at least width * 4 bytes long.
+     */
+    void copyRow(std::uint32_t y, std::uint8_t* destination) const;
+
+    /**
+     * @brief copyGrayRow Converts a row of pixels to GRAY8, see geometrize::luminance.
+     * @param y The y-coordinate of the row.
+     * @param destination Where to write the converted row, must be at least width bytes long.
+     */
+    void copyGrayRow(std::uint32_t y, std::uint8_t* destination) const;
+
+private:
+    const std::uint8_t* m_data; ///< The pixel data.
+    std::uint32_t m_width; ///< The width of the bitmap.
+    std::uint32_t m_height; ///< The height of the bitmap.
+    std::size_t m_stride; ///< The number of bytes from the start of one row to the start of the next.
+    geometrize::PixelFormat m_format; ///< The layout of the pixels.
+};
+
+}
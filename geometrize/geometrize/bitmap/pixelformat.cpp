@@ -0,0 +1,20 @@
+#include "pixelformat.h"
+
+#include <cstddef>
+
+namespace geometrize
+{
+
+std::size_t getBytesPerPixel(const geometrize::PixelFormat format)
+{
+    switch(format) {
+    case geometrize::PixelFormat::RGB888:
+        return 3U;
+    case geometrize::PixelFormat::GRAY8:
+        return 1U;
+    default:
+        return 4U;
+    }
+}
+
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace geometrize
+{
+
+/**
+ * @brief The PixelFormat enum specifies the layouts of pixel data that bitmaps and bitmap views can hold.
+ * Bitmaps are either RGBA8888 or GRAY8, bitmap views can read all of the formats.
+ */
+enum class PixelFormat : std::uint32_t
+{
+    RGBA8888 = 0U, ///< Four bytes per pixel, in red, green, blue, alpha order. This is the default layout of geometrize::Bitmap.
+    BGRA8888 = 1U, ///< Four bytes per pixel, in blue, green, red, alpha order.
+    RGB888 = 2U, ///< Three bytes per pixel, in red, green, blue order. The pixels are read as opaque.
+    GRAY8 = 3U ///< One byte per pixel, the luminance. The pixels are read as opaque gray.
+};
+
+/**
+ * @brief getBytesPerPixel Gets the number of bytes each pixel takes in a pixel format.
+ * @param format The pixel format.
+ * @return The number of bytes per pixel.
+ */
+std::size_t getBytesPerPixel(geometrize::PixelFormat format);
+
+}
@@ -1,5 +1,7 @@
 #include "rgba.h"
 
+#include <cstdint>
+
 namespace geometrize
 {
 
@@ -13,4 +15,10 @@ bool operator!=(const geometrize::rgba& lhs, const geometrize::rgba& rhs)
     return lhs.r != rhs.r || lhs.g != rhs.g || lhs.b != rhs.b || lhs.a != rhs.a;
 }
 
+std::uint8_t luminance(const geometrize::rgba& color)
+{
+    // The weights add up to 256, so gray colors keep their value
+    return static_cast<std::uint8_t>((77U * color.r + 150U * color.g + 29U * color.b + 128U) >> 8);
+}
+
 }
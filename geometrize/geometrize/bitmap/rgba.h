@@ -20,4 +20,11 @@ struct rgba
 bool operator==(const geometrize::rgba& lhs, const geometrize::rgba& rhs);
 bool operator!=(const geometrize::rgba& lhs, const geometrize::rgba& rhs);
 
+/**
+ * @brief luminance Calculates the luminance of a color with the Rec. 601 weights, ignoring its alpha. The luminance of a gray color is its gray value.
+ * @param color The color.
+ * @return The luminance (0-255).
+ */
+std::uint8_t luminance(const geometrize::rgba& color);
+
 }
@@ -1,11 +1,18 @@
 #include "commonutil.h"
 
+#include <algorithm>
+#include <array>
 #include <assert.h>
+#include <cstddef>
 #include <cstdint>
 #include <random>
+#include <vector>
 
 #include "bitmap/bitmap.h"
+#include "bitmap/pixelformat.h"
 #include "bitmap/rgba.h"
+#include "spankernels.h"
+#include "threadpool.h"
 
 namespace geometrize
 {
@@ -13,47 +20,118 @@ namespace geometrize
 namespace commonutil
 {
 
-thread_local static std::mt19937 mt(std::random_device{}());
-thread_local static std::uniform_int_distribution<std::int32_t> pick;
+thread_local static geometrize::commonutil::RandomGenerator generator(std::random_device{}());
 
 void seedRandomGenerator(const std::uint32_t seed)
 {
-    mt.seed(seed);
+    generator.seed(seed);
+}
+
+std::uint32_t deriveSeed(const std::uint32_t seed, const std::uint32_t step, const std::uint32_t index)
+{
+    // Element index + 1 of the SplitMix64 sequence that starts from the seed and step
+    std::uint64_t z{(static_cast<std::uint64_t>(seed) << 32U) | step};
+    z += 0x9E3779B97F4A7C15ULL * (static_cast<std::uint64_t>(index) + 1U);
+    z = (z ^ (z >> 30U)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27U)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31U;
+    return static_cast<std::uint32_t>(z >> 32U);
 }
 
 std::int32_t randomRange(const std::int32_t min, const std::int32_t max)
 {
     assert(min <= max);
-    return pick(mt, std::uniform_int_distribution<std::int32_t>::param_type{min, max});
+    return generator.range(min, max);
 }
 
-geometrize::rgba getAverageImageColor(const geometrize::Bitmap& image)
+void randomRange(const std::int32_t min, const std::int32_t max, std::int32_t* const values, const std::size_t count)
 {
-    const std::vector<std::uint8_t>& data{image.getDataRef()};
-    const std::size_t size{data.size()};
-    if(size == 0) {
-        return geometrize::rgba{0, 0, 0, 0};
-    }
+    assert(min <= max);
+    generator.range(min, max, values, count);
+}
 
-    const std::size_t numPixels{size / 4U};
+namespace
+{
+
+const std::size_t averageBandPixels{1U << 18}; ///< The approximate number of pixels in each of the bands of rows that getAverageImageColor splits between threads.
 
-    std::uint32_t totalRed{0};
-    std::uint32_t totalGreen{0};
-    std::uint32_t totalBlue{0};
-    for(std::size_t i = 0; i < size; i += 4U) {
-        totalRed += data[i];
-        totalGreen += data[i + 1U];
-        totalBlue += data[i + 2U];
+// Adds up each channel of a run of pixels, reading GRAY8 pixels as the opaque gray RGBA colors they stand for
+void sumChannels(const std::uint8_t* pixels, const std::size_t count, const geometrize::PixelFormat format, std::uint64_t (&totals)[4])
+{
+    if(format == geometrize::PixelFormat::GRAY8) {
+        const std::uint64_t total{geometrize::kernels::sumGray(pixels, count)};
+        totals[0] += total;
+        totals[1] += total;
+        totals[2] += total;
+        totals[3] += static_cast<std::uint64_t>(UINT8_MAX) * count;
+        return;
     }
+    geometrize::kernels::sumChannels(pixels, count, totals);
+}
 
+geometrize::rgba averageColor(const std::uint64_t (&totals)[4], const std::size_t numPixels)
+{
     return geometrize::rgba{
-        static_cast<std::uint8_t>(totalRed / numPixels),
-        static_cast<std::uint8_t>(totalGreen / numPixels),
-        static_cast<std::uint8_t>(totalBlue / numPixels),
+        static_cast<std::uint8_t>(totals[0] / numPixels),
+        static_cast<std::uint8_t>(totals[1] / numPixels),
+        static_cast<std::uint8_t>(totals[2] / numPixels),
         static_cast<std::uint8_t>(UINT8_MAX)
     };
 }
 
 }
 
+geometrize::rgba getAverageImageColor(const geometrize::Bitmap& image)
+{
+    const std::size_t numPixels{static_cast<std::size_t>(image.getWidth()) * image.getHeight()};
+    if(numPixels == 0) {
+        return geometrize::rgba{0, 0, 0, 0};
+    }
+
+    std::uint64_t totals[4]{0, 0, 0, 0};
+    sumChannels(image.getDataRef().data(), numPixels, image.getFormat(), totals);
+    return averageColor(totals, numPixels);
+}
+
+geometrize::rgba getAverageImageColor(const geometrize::Bitmap& image, geometrize::ThreadPool& threadPool)
+{
+    const std::size_t width{image.getWidth()};
+    const std::size_t height{image.getHeight()};
+    if(width == 0 || height == 0) {
+        return getAverageImageColor(image);
+    }
+
+    // Split the rows into bands whatever the number of threads, the totals are exact so the result does not depend on it anyway
+    const std::size_t bandRows{(std::max)(static_cast<std::size_t>(1U), averageBandPixels / width)};
+    const std::size_t bandCount{(height + bandRows - 1U) / bandRows};
+    const std::uint8_t* data{image.getDataRef().data()};
+    const std::size_t bytesPerPixel{geometrize::getBytesPerPixel(image.getFormat())};
+    std::vector<std::array<std::uint64_t, 4>> bandTotals(bandCount);
+    threadPool.run(static_cast<std::uint32_t>(bandCount), [&](const std::uint32_t band, const std::uint32_t) {
+        const std::size_t y1{band * bandRows};
+        const std::size_t y2{(std::min)(height, y1 + bandRows)};
+        std::uint64_t totals[4]{0, 0, 0, 0};
+        sumChannels(data + y1 * width * bytesPerPixel, (y2 - y1) * width, image.getFormat(), totals);
+        bandTotals[band] = {{totals[0], totals[1], totals[2], totals[3]}};
+    });
+
+    std::uint64_t totals[4]{0, 0, 0, 0};
+    for(const std::array<std::uint64_t, 4>& band : bandTotals) {
+        for(std::size_t i = 0; i < 4U; i++) {
+            totals[i] += band[i];
+        }
+    }
+    return averageColor(totals, width * height);
+}
+
+bool isOpaque(const geometrize::Bitmap& image)
+{
+    const std::size_t numPixels{static_cast<std::size_t>(image.getWidth()) * image.getHeight()};
+    std::uint64_t totals[4]{0, 0, 0, 0};
+    sumChannels(image.getDataRef().data(), numPixels, image.getFormat(), totals);
+    return totals[3] == static_cast<std::uint64_t>(UINT8_MAX) * numPixels;
+}
+
+}
+
 }
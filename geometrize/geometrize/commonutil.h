@@ -1,6 +1,7 @@
 #pragma once
 
 #include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <vector>
 
@@ -9,6 +10,7 @@
 namespace geometrize
 {
 class Bitmap;
+class ThreadPool;
 }
 
 namespace geometrize
@@ -17,12 +19,118 @@ namespace geometrize
 namespace commonutil
 {
 
+/**
+ * @brief The RandomGenerator class is a small and fast pseudorandom number generator (xoshiro128**).
+ * Its state is filled from the seed using SplitMix64, so nearby seeds (such as those given by deriveSeed for consecutive indices) give unrelated streams.
+ * Bounded integers are sampled with Lemire's multiply-and-reject method, which rarely needs more than one number and avoids division in the common case.
+ * @author Sam Twidale (http://samcodes.co.uk/)
+ */
+class RandomGenerator
+{
+public:
+    /**
+     * @brief RandomGenerator Creates a random number generator.
+     * @param seed The random seed.
+     */
+    explicit RandomGenerator(const std::uint64_t seed = 0)
+    {
+        this->seed(seed);
+    }
+
+    /**
+     * @brief seed Reseeds the random number generator, starting a new stream.
+     * @param seed The random seed.
+     */
+    void seed(std::uint64_t seed)
+    {
+        for(std::size_t i = 0; i < 4U; i++) {
+            seed += 0x9E3779B97F4A7C15ULL;
+            std::uint64_t z{seed};
+            z = (z ^ (z >> 30U)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27U)) * 0x94D049BB133111EBULL;
+            m_state[i] = static_cast<std::uint32_t>((z ^ (z >> 31U)) >> 32U);
+        }
+    }
+
+    /**
+     * @brief next Gets the next random number in the stream.
+     * @return A random integer, uniformly distributed over all 32-bit values.
+     */
+    std::uint32_t next()
+    {
+        const std::uint32_t result{rotl(m_state[1] * 5U, 7U) * 9U};
+        const std::uint32_t t{m_state[1] << 9U};
+        m_state[2] ^= m_state[0];
+        m_state[3] ^= m_state[1];
+        m_state[1] ^= m_state[2];
+        m_state[0] ^= m_state[3];
+        m_state[2] ^= t;
+        m_state[3] = rotl(m_state[3], 11U);
+        return result;
+    }
+
+    /**
+     * @brief range Returns a random integer in the range, inclusive.
+     * @param min The lower bound.
+     * @param max The upper bound.
+     * @return The random integer in the range.
+     */
+    std::int32_t range(const std::int32_t min, const std::int32_t max)
+    {
+        const std::uint32_t size{static_cast<std::uint32_t>(max) - static_cast<std::uint32_t>(min) + 1U};
+        if(size == 0) {
+            return static_cast<std::int32_t>(next()); // The range covers every 32-bit value
+        }
+
+        std::uint64_t m{static_cast<std::uint64_t>(next()) * size};
+        if(static_cast<std::uint32_t>(m) < size) {
+            const std::uint32_t threshold{(0U - size) % size};
+            while(static_cast<std::uint32_t>(m) < threshold) {
+                m = static_cast<std::uint64_t>(next()) * size;
+            }
+        }
+        return static_cast<std::int32_t>(static_cast<std::uint32_t>(min) + static_cast<std::uint32_t>(m >> 32U));
+    }
+
+    /**
+     * @brief range Fills an array with random integers in the range, inclusive. Gives the same values as calling range(min, max) count times.
+     * @param min The lower bound.
+     * @param max The upper bound.
+     * @param values The array to fill.
+     * @param count The number of values to fill.
+     */
+    void range(const std::int32_t min, const std::int32_t max, std::int32_t* const values, const std::size_t count)
+    {
+        for(std::size_t i = 0; i < count; i++) {
+            values[i] = range(min, max);
+        }
+    }
+
+private:
+    static std::uint32_t rotl(const std::uint32_t x, const std::uint32_t k)
+    {
+        return (x << k) | (x >> (32U - k));
+    }
+
+    std::uint32_t m_state[4]; ///< The generator state.
+};
+
 /**
  * @brief seedRandomGenerator Seeds the (thread-local) random number generators.
  * @param seed The random seed.
  */
 void seedRandomGenerator(std::uint32_t seed);
 
+/**
+ * @brief deriveSeed Derives a random seed from a base seed and a pair of counters, such as a step number and the index of a task within that step.
+ * Different counters give unrelated seeds, so work can be seeded by what it is rather than by the order it was handed out in.
+ * @param seed The base random seed.
+ * @param step The first counter, e.g. the number of steps taken so far.
+ * @param index The second counter, e.g. the index of a task or candidate shape within the step.
+ * @return The derived random seed.
+ */
+std::uint32_t deriveSeed(std::uint32_t seed, std::uint32_t step, std::uint32_t index);
+
 /**
  * @brief randomRange Returns a random integer in the range, inclusive. Uses thread-local random number generators under the hood.
  * To ensure deterministic shape generation that can be repeated for different seeds, this should be used for shape mutation, but nothing else.
@@ -32,6 +140,15 @@ void seedRandomGenerator(std::uint32_t seed);
  */
 std::int32_t randomRange(std::int32_t min, std::int32_t max);
 
+/**
+ * @brief randomRange Fills an array with random integers in the range, inclusive. Gives the same values as calling randomRange(min, max) count times, with less overhead.
+ * @param min The lower bound.
+ * @param max The upper bound.
+ * @param values The array to fill.
+ * @param count The number of values to fill.
+ */
+void randomRange(std::int32_t min, std::int32_t max, std::int32_t* values, std::size_t count);
+
 /**
  * @brief clamp Clamps a value within a range.
  * @param value The value to clamp.
@@ -51,6 +168,21 @@ template<typename T> T clamp(const T& value, const T& lower, const T& upper)
  */
 geometrize::rgba getAverageImageColor(const geometrize::Bitmap& image);
 
+/**
+ * @brief getAverageImageColor Computes the average RGB color of the pixels in the bitmap, splitting the rows between the threads of a pool. Gives the same result as the other getAverageImageColor.
+ * @param image The image whose average color will be calculated.
+ * @param threadPool The thread pool to run on.
+ * @return The average RGB color of the image, RGBA8888 format. Alpha is set to opaque (255).
+ */
+geometrize::rgba getAverageImageColor(const geometrize::Bitmap& image, geometrize::ThreadPool& threadPool);
+
+/**
+ * @brief isOpaque Checks whether every pixel in the bitmap is opaque.
+ * @param image The image to check.
+ * @return True if every pixel has an alpha of 255, else false. GRAY8 images are always opaque.
+ */
+bool isOpaque(const geometrize::Bitmap& image);
+
 }
 
 }
@@ -1,17 +1,24 @@
 #include "core.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <cstddef>
 #include <cstdint>
 #include <vector>
 
 #include "bitmap/bitmap.h"
+#include "bitmap/pixelformat.h"
 #include "bitmap/rgba.h"
 #include "commonutil.h"
+#include "momenttables.h"
 #include "rasterizer/rasterizer.h"
 #include "rasterizer/scanline.h"
+#include "shape/shapeundo.h"
 #include "shape/shapetypes.h"
+#include "spankernels.h"
 #include "state.h"
+#include "threadpool.h"
 
 namespace geometrize
 {
@@ -19,41 +26,19 @@ namespace geometrize
 namespace core
 {
 
-geometrize::rgba computeColor(
-        const geometrize::Bitmap& target,
-        const geometrize::Bitmap& current,
-        const std::vector<geometrize::Scanline>& lines,
-        const std::uint8_t alpha)
-{
-    std::int64_t totalRed{0};
-    std::int64_t totalGreen{0};
-    std::int64_t totalBlue{0};
-    std::int64_t count{0};
-    const std::int32_t a{static_cast<std::int32_t>(257.0f * 255.0f / static_cast<float>(alpha))};
+const std::size_t differenceBandPixels{1U << 18}; ///< The approximate number of pixels in each of the bands of rows that differenceFull splits between threads.
 
-    // For each scanline
-    for(const geometrize::Scanline& line : lines) {
-        const std::int32_t y{line.y};
-        for(std::int32_t x = line.x1; x <= line.x2; x++) {
-            // Get the overlapping target and current colors
-            const geometrize::rgba t(target.getPixel(x, y));
-            const geometrize::rgba c(current.getPixel(x, y));
-
-            const std::int32_t tr{t.r};
-            const std::int32_t tg{t.g};
-            const std::int32_t tb{t.b};
-            const std::int32_t cr{c.r};
-            const std::int32_t cg{c.g};
-            const std::int32_t cb{c.b};
-
-            // Mix the red, green and blue components, blending by the given alpha value
-            totalRed += static_cast<std::int64_t>((tr - cr) * a + cr * 257);
-            totalGreen += static_cast<std::int64_t>((tg - cg) * a + cg * 257);
-            totalBlue += static_cast<std::int64_t>((tb - cb) * a + cb * 257);
-            count++;
-        }
-    }
+// GRAY8 bitmaps are scored as if they were the opaque RGBA bitmaps they read as, so the red, green and blue channels
+// each add the gray difference and the alpha channel adds nothing, and the scores match those of the RGBA model exactly
+const std::int64_t grayChannelCount{3}; ///< The number of RGBA channels each gray difference is counted for.
 
+inline geometrize::rgba averageColor(
+        const std::int64_t totalRed,
+        const std::int64_t totalGreen,
+        const std::int64_t totalBlue,
+        const std::int64_t count,
+        const std::uint8_t alpha)
+{
     // Early out to avoid integer divide by 0
     if(count == 0) {
         return geometrize::rgba{0, 0, 0, 0};
@@ -71,26 +56,129 @@ geometrize::rgba computeColor(
     return geometrize::rgba{r, g, b, alpha};
 }
 
+inline float partialScore(const float score, const double rgbaCount, const std::int64_t delta)
+{
+    // Rebuild the total squared error from the score and add the change to it
+    // This is done in double, since on large images the total is far beyond the precision of a float, and the change one shape makes would be lost
+    const double total{static_cast<double>(score) * 255.0 * static_cast<double>(score) * 255.0 * rgbaCount + static_cast<double>(delta)};
+
+    // NOTE needs work. This is a workaround because when score/energy is tiny the total can come out negative
+    if(total < 0.0) {
+        return score;
+    }
+    return static_cast<float>(std::sqrt(total / rgbaCount) / 255.0);
+}
+
+geometrize::rgba computeColor(
+        const geometrize::Bitmap& target,
+        const geometrize::Bitmap& current,
+        const std::vector<geometrize::Scanline>& lines,
+        const std::uint8_t alpha)
+{
+    const std::int64_t a{static_cast<std::int32_t>(257.0f * 255.0f / static_cast<float>(alpha))};
+
+    // Sum the target and current colors under the scanlines
+    const std::uint8_t* targetData{target.getDataRef().data()};
+    const std::uint8_t* currentData{current.getDataRef().data()};
+    const std::size_t width{target.getWidth()};
+    const bool gray{target.getFormat() == geometrize::PixelFormat::GRAY8};
+    const std::size_t bytesPerPixel{geometrize::getBytesPerPixel(target.getFormat())};
+    std::uint64_t targetTotals[4]{0, 0, 0, 0};
+    std::uint64_t currentTotals[4]{0, 0, 0, 0};
+    std::int64_t count{0};
+    for(const geometrize::Scanline& line : lines) {
+        const std::size_t offset{(static_cast<std::size_t>(line.y) * width + static_cast<std::size_t>(line.x1)) * bytesPerPixel};
+        const std::size_t length{static_cast<std::size_t>(line.x2 - line.x1 + 1)};
+        if(gray) {
+            targetTotals[0] += geometrize::kernels::sumGray(targetData + offset, length);
+            currentTotals[0] += geometrize::kernels::sumGray(currentData + offset, length);
+        } else {
+            geometrize::kernels::sumChannels(targetData + offset, length, targetTotals);
+            geometrize::kernels::sumChannels(currentData + offset, length, currentTotals);
+        }
+        count += static_cast<std::int64_t>(length);
+    }
+    if(gray) {
+        targetTotals[1] = targetTotals[2] = targetTotals[0];
+        currentTotals[1] = currentTotals[2] = currentTotals[0];
+    }
+
+    // Mix the red, green and blue components, blending by the given alpha value
+    // Equivalent to summing the per-pixel blends (t - c) * a + c * 257, since the blend is linear in the target and current colors
+    const std::int64_t tr{static_cast<std::int64_t>(targetTotals[0])};
+    const std::int64_t tg{static_cast<std::int64_t>(targetTotals[1])};
+    const std::int64_t tb{static_cast<std::int64_t>(targetTotals[2])};
+    const std::int64_t cr{static_cast<std::int64_t>(currentTotals[0])};
+    const std::int64_t cg{static_cast<std::int64_t>(currentTotals[1])};
+    const std::int64_t cb{static_cast<std::int64_t>(currentTotals[2])};
+    const std::int64_t totalRed{(tr - cr) * a + cr * 257};
+    const std::int64_t totalGreen{(tg - cg) * a + cg * 257};
+    const std::int64_t totalBlue{(tb - cb) * a + cb * 257};
+
+    return averageColor(totalRed, totalGreen, totalBlue, count, alpha);
+}
+
+geometrize::rgba computeColor(const geometrize::Moments& moments, const std::uint8_t alpha)
+{
+    const std::int64_t a{static_cast<std::int32_t>(257.0f * 255.0f / static_cast<float>(alpha))};
+
+    // Equivalent to summing the per-pixel blends in the other computeColor, since the blend is linear in the target and current colors
+    const std::int64_t totalRed{(moments.target[0] - moments.current[0]) * a + moments.current[0] * 257};
+    const std::int64_t totalGreen{(moments.target[1] - moments.current[1]) * a + moments.current[1] * 257};
+    const std::int64_t totalBlue{(moments.target[2] - moments.current[2]) * a + moments.current[2] * 257};
+
+    return averageColor(totalRed, totalGreen, totalBlue, moments.count, alpha);
+}
+
 float differenceFull(const geometrize::Bitmap& first, const geometrize::Bitmap& second)
 {
     assert(first.getWidth() == second.getWidth());
     assert(first.getHeight() == second.getHeight());
 
+    assert(first.getFormat() == second.getFormat());
+
     const std::size_t width{first.getWidth()};
     const std::size_t height{first.getHeight()};
-    std::uint64_t total{0};
+    const std::uint8_t* firstData{first.getDataRef().data()};
+    const std::uint8_t* secondData{second.getDataRef().data()};
+    const std::uint64_t total{first.getFormat() == geometrize::PixelFormat::GRAY8
+        ? grayChannelCount * geometrize::kernels::squaredDifferenceGray(firstData, secondData, width * height)
+        : geometrize::kernels::squaredDifference(firstData, secondData, width * height)};
+    return std::sqrt(static_cast<float>(total) / (static_cast<float>(width) * static_cast<float>(height) * 4.0f)) / 255.0f;
+}
 
-    for(std::uint32_t y = 0; y < height; y++) {
-        for(std::uint32_t x = 0; x < width; x++) {
-            const geometrize::rgba f(first.getPixel(x, y));
-            const geometrize::rgba s(second.getPixel(x, y));
+float differenceFull(const geometrize::Bitmap& first, const geometrize::Bitmap& second, geometrize::ThreadPool& threadPool)
+{
+    assert(first.getWidth() == second.getWidth());
+    assert(first.getHeight() == second.getHeight());
+    assert(first.getFormat() == second.getFormat());
 
-            const std::int32_t dr = {static_cast<std::int32_t>(f.r) - static_cast<std::int32_t>(s.r)};
-            const std::int32_t dg = {static_cast<std::int32_t>(f.g) - static_cast<std::int32_t>(s.g)};
-            const std::int32_t db = {static_cast<std::int32_t>(f.b) - static_cast<std::int32_t>(s.b)};
-            const std::int32_t da = {static_cast<std::int32_t>(f.a) - static_cast<std::int32_t>(s.a)};
-            total += (dr * dr + dg * dg + db * db + da * da);
-        }
+    const std::size_t width{first.getWidth()};
+    const std::size_t height{first.getHeight()};
+    if(width == 0 || height == 0) {
+        return differenceFull(first, second);
+    }
+
+    // Split the rows into bands of roughly the same number of pixels, whatever the number of threads, and add up the exact integer sums of the bands
+    const std::size_t bandRows{(std::max)(static_cast<std::size_t>(1U), differenceBandPixels / width)};
+    const std::size_t bandCount{(height + bandRows - 1U) / bandRows};
+    const std::uint8_t* firstData{first.getDataRef().data()};
+    const std::uint8_t* secondData{second.getDataRef().data()};
+    const bool gray{first.getFormat() == geometrize::PixelFormat::GRAY8};
+    const std::size_t bytesPerPixel{geometrize::getBytesPerPixel(first.getFormat())};
+    std::vector<std::uint64_t> totals(bandCount, 0U);
+    threadPool.run(static_cast<std::uint32_t>(bandCount), [&](const std::uint32_t band, const std::uint32_t) {
+        const std::size_t y1{band * bandRows};
+        const std::size_t y2{(std::min)(height, y1 + bandRows)};
+        const std::size_t offset{y1 * width * bytesPerPixel};
+        totals[band] = gray
+            ? grayChannelCount * geometrize::kernels::squaredDifferenceGray(firstData + offset, secondData + offset, (y2 - y1) * width)
+            : geometrize::kernels::squaredDifference(firstData + offset, secondData + offset, (y2 - y1) * width);
+    });
+
+    std::uint64_t total{0};
+    for(const std::uint64_t bandTotal : totals) {
+        total += bandTotal;
     }
     return std::sqrt(static_cast<float>(total) / (static_cast<float>(width) * static_cast<float>(height) * 4.0f)) / 255.0f;
 }
@@ -102,37 +190,66 @@ float differencePartial(
         const float score,
         const std::vector<Scanline>& lines)
 {
-    const std::size_t rgbaCount{target.getWidth() * target.getHeight() * 4U};
-    std::uint64_t total{static_cast<std::uint64_t>((score * 255.0f) * (score * 255.0f) * rgbaCount)};
+    const double rgbaCount{static_cast<double>(target.getWidth()) * static_cast<double>(target.getHeight()) * 4.0};
+    std::int64_t change{0};
+    const std::uint8_t* targetData{target.getDataRef().data()};
+    const std::uint8_t* beforeData{before.getDataRef().data()};
+    const std::uint8_t* afterData{after.getDataRef().data()};
+    const std::size_t width{target.getWidth()};
+    const bool gray{target.getFormat() == geometrize::PixelFormat::GRAY8};
+    const std::size_t bytesPerPixel{geometrize::getBytesPerPixel(target.getFormat())};
     for(const geometrize::Scanline& line : lines) {
-        const std::int32_t y{line.y};
-        for(std::int32_t x = line.x1; x <= line.x2; x++) {
-            const geometrize::rgba t(target.getPixel(x, y));
-            const geometrize::rgba b(before.getPixel(x, y));
-            const geometrize::rgba a(after.getPixel(x, y));
-
-            const std::int32_t dtbr{static_cast<std::int32_t>(t.r) - static_cast<std::int32_t>(b.r)};
-            const std::int32_t dtbg{static_cast<std::int32_t>(t.g) - static_cast<std::int32_t>(b.g)};
-            const std::int32_t dtbb{static_cast<std::int32_t>(t.b) - static_cast<std::int32_t>(b.b)};
-            const std::int32_t dtba{static_cast<std::int32_t>(t.a) - static_cast<std::int32_t>(b.a)};
-
-            const std::int32_t dtar{static_cast<std::int32_t>(t.r) - static_cast<std::int32_t>(a.r)};
-            const std::int32_t dtag{static_cast<std::int32_t>(t.g) - static_cast<std::int32_t>(a.g)};
-            const std::int32_t dtab{static_cast<std::int32_t>(t.b) - static_cast<std::int32_t>(a.b)};
-            const std::int32_t dtaa{static_cast<std::int32_t>(t.a) - static_cast<std::int32_t>(a.a)};
-
-            total -= static_cast<std::uint64_t>(dtbr * dtbr + dtbg * dtbg + dtbb * dtbb + dtba * dtba);
-            total += static_cast<std::uint64_t>(dtar * dtar + dtag * dtag + dtab * dtab + dtaa * dtaa);
-        }
+        const std::size_t offset{(static_cast<std::size_t>(line.y) * width + static_cast<std::size_t>(line.x1)) * bytesPerPixel};
+        const std::size_t length{static_cast<std::size_t>(line.x2 - line.x1 + 1)};
+        const std::int64_t delta{gray
+            ? grayChannelCount * geometrize::kernels::differenceGray(targetData + offset, beforeData + offset, afterData + offset, length)
+            : geometrize::kernels::difference(targetData + offset, beforeData + offset, afterData + offset, length)};
+        change += delta;
     }
 
-    const float result{std::sqrt(static_cast<float>(total) / static_cast<float>(rgbaCount)) / 255.0f};
+    return partialScore(score, rgbaCount, change);
+}
 
-    // NOTE needs work. This is a workaround because when score/energy is tiny total can unintentionally underflow
-    if(result > 1.0f) {
-        return score;
+float differencePartial(
+        const geometrize::Bitmap& target,
+        const geometrize::Bitmap& before,
+        const geometrize::rgba color,
+        const float score,
+        const std::vector<Scanline>& lines)
+{
+    return differencePartial(target, before, color, score, lines, false);
+}
+
+float differencePartial(
+        const geometrize::Bitmap& target,
+        const geometrize::Bitmap& before,
+        const geometrize::rgba color,
+        const float score,
+        const std::vector<Scanline>& lines,
+        const bool opaque)
+{
+    // Blend each covered pixel in registers and accumulate the change in squared error against the target
+    // This gives the same result as drawing the scanlines into a copy of the before bitmap and comparing it with the other differencePartial
+    const bool gray{target.getFormat() == geometrize::PixelFormat::GRAY8};
+    const geometrize::kernels::BlendConstants blend(gray
+        ? geometrize::kernels::grayBlendConstants(geometrize::luminance(color), color.a)
+        : geometrize::kernels::blendConstants(color.r, color.g, color.b, color.a, opaque));
+    const double rgbaCount{static_cast<double>(target.getWidth()) * static_cast<double>(target.getHeight()) * 4.0};
+    std::int64_t change{0};
+    const std::uint8_t* targetData{target.getDataRef().data()};
+    const std::uint8_t* beforeData{before.getDataRef().data()};
+    const std::size_t width{target.getWidth()};
+    const std::size_t bytesPerPixel{geometrize::getBytesPerPixel(target.getFormat())};
+    for(const geometrize::Scanline& line : lines) {
+        const std::size_t offset{(static_cast<std::size_t>(line.y) * width + static_cast<std::size_t>(line.x1)) * bytesPerPixel};
+        const std::size_t length{static_cast<std::size_t>(line.x2 - line.x1 + 1)};
+        const std::int64_t delta{gray
+            ? grayChannelCount * geometrize::kernels::differenceBlendedGray(targetData + offset, beforeData + offset, length, blend)
+            : geometrize::kernels::differenceBlended(targetData + offset, beforeData + offset, length, blend)};
+        change += delta;
     }
-    return result;
+
+    return partialScore(score, rgbaCount, change);
 }
 
 geometrize::State bestRandomState(
@@ -142,16 +259,15 @@ geometrize::State bestRandomState(
         const std::uint32_t n,
         const geometrize::Bitmap& target,
         const geometrize::Bitmap& current,
-        geometrize::Bitmap& buffer,
         const float lastScore)
 {
     geometrize::State bestState(model, shapeTypes, alpha);
-    float bestEnergy{bestState.calculateEnergy(target, current, buffer, lastScore)};
+    float bestEnergy{bestState.calculateEnergy(target, current, lastScore)};
 
     for(std::uint32_t i = 0; i <= n; i++) {
         geometrize::State state(model, shapeTypes, alpha);
 
-        const float energy{state.calculateEnergy(target, current, buffer, lastScore)};
+        const float energy{state.calculateEnergy(target, current, lastScore)};
         if(i == 0 || energy < bestEnergy) {
             bestEnergy = energy;
             bestState = state;
@@ -166,19 +282,26 @@ geometrize::State hillClimb(
         const std::uint32_t maxAge,
         const geometrize::Bitmap& target,
         const geometrize::Bitmap& current,
-        geometrize::Bitmap& buffer,
         const float lastScore)
 {
+    // The working state always matches the best state at the start of each iteration, so a rejected mutation is undone
+    // by reverting the parameters it changed, or by copying the best state back if the mutator did not record them
     geometrize::State s(state);
     geometrize::State bestState(state);
+    geometrize::ShapeUndo undo;
     float bestEnergy{bestState.m_score};
 
     std::uint32_t age{0};
     while(age < maxAge) {
-        const geometrize::State undo{s.mutate()};
-        const float energy{s.calculateEnergy(target, current, buffer, lastScore)};
+        s.mutate(undo);
+        const float energy{s.calculateEnergy(target, current, lastScore)};
         if(energy >= bestEnergy) {
-            s = undo;
+            if(undo.isComplete()) {
+                undo.revert();
+                s.m_score = bestEnergy;
+            } else {
+                s = bestState;
+            }
         } else {
             bestEnergy = energy;
             bestState = s;
@@ -198,11 +321,10 @@ geometrize::State bestHillClimbState(
         const std::uint32_t age,
         const geometrize::Bitmap& target,
         const geometrize::Bitmap& current,
-        geometrize::Bitmap& buffer,
         const float lastScore)
 {
-    const geometrize::State state{bestRandomState(model, shapeTypes, alpha, n, target, current, buffer, lastScore)};
-    return hillClimb(state, age, target, current, buffer, lastScore);
+    const geometrize::State state{bestRandomState(model, shapeTypes, alpha, n, target, current, lastScore)};
+    return hillClimb(state, age, target, current, lastScore);
 }
 
 float energy(
@@ -210,13 +332,62 @@ float energy(
         const std::uint32_t alpha,
         const geometrize::Bitmap& target,
         const geometrize::Bitmap& current,
-        geometrize::Bitmap& buffer,
         const float score)
 {
-    const geometrize::rgba color(computeColor(target, current, lines, alpha)); // Calculate best color for areas covered by the scanlines
-    geometrize::copyLines(buffer, current, lines); // Copy area covered by scanlines to buffer bitmap
-    geometrize::drawLines(buffer, color, lines); // Blend scanlines into the buffer using the color calculated earlier
-    return differencePartial(target, current, buffer, score, lines); // Get error measure between areas of current and modified buffers covered by scanlines
+    return energy(lines, alpha, target, current, score, false);
+}
+
+float energy(
+        const std::vector<geometrize::Scanline>& lines,
+        const std::uint32_t alpha,
+        const geometrize::Bitmap& target,
+        const geometrize::Bitmap& current,
+        const float score,
+        const bool opaque)
+{
+    const geometrize::rgba color(computeColor(target, current, lines, static_cast<std::uint8_t>(alpha))); // Calculate best color for areas covered by the scanlines
+    return differencePartial(target, current, color, score, lines, opaque); // Get error measure as if the scanlines were drawn over the current bitmap with that color
+}
+
+float energy(
+        const std::vector<geometrize::Scanline>& lines,
+        const std::uint32_t alpha,
+        const geometrize::MomentTables& moments,
+        const float score)
+{
+    return energy(moments.getMoments(lines), alpha, moments.getWidth(), moments.getHeight(), score);
+}
+
+float energy(
+        const geometrize::Moments& moments,
+        const std::uint32_t alpha,
+        const std::uint32_t width,
+        const std::uint32_t height,
+        const float score)
+{
+    const geometrize::rgba color(computeColor(moments, static_cast<std::uint8_t>(alpha)));
+
+    // Model the blend geometrize::drawLines does as after = p * before + q, ignoring its rounding
+    // p is shared by all channels, q is the alpha-premultiplied color (scaled to 0-255) for each channel
+    const double sa{static_cast<double>(color.a * 257U)};
+    const double p{(static_cast<double>(UINT16_MAX) - sa) * 257.0 / (static_cast<double>(UINT16_MAX) * 256.0)};
+    const double q[4]{
+        static_cast<double>((color.r * 257U * color.a) / UINT8_MAX) / 256.0,
+        static_cast<double>((color.g * 257U * color.a) / UINT8_MAX) / 256.0,
+        static_cast<double>((color.b * 257U * color.a) / UINT8_MAX) / 256.0,
+        sa / 256.0
+    };
+
+    // Sum of (t - (p * c + q))^2 - (t - c)^2 over the covered pixels, expanded in terms of the moments
+    const double n{static_cast<double>(moments.count)};
+    double delta{(p * p - 1.0) * static_cast<double>(moments.currentSquared) - 2.0 * (p - 1.0) * static_cast<double>(moments.targetCurrent)};
+    for(std::size_t i = 0; i < 4U; i++) {
+        delta += n * q[i] * q[i] - 2.0 * q[i] * static_cast<double>(moments.target[i]) + 2.0 * p * q[i] * static_cast<double>(moments.current[i]);
+    }
+
+    const double rgbaCount{static_cast<double>(width) * static_cast<double>(height) * 4.0};
+    const double total{(std::max)(0.0, static_cast<double>(score) * 255.0 * static_cast<double>(score) * 255.0 * rgbaCount + delta)};
+    return static_cast<float>(std::sqrt(total / rgbaCount) / 255.0);
 }
 
 }
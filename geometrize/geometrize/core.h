@@ -11,6 +11,9 @@
 namespace geometrize
 {
 class Bitmap;
+class MomentTables;
+struct Moments;
+class ThreadPool;
 }
 
 namespace geometrize
@@ -38,6 +41,14 @@ geometrize::rgba computeColor(
         const std::vector<geometrize::Scanline>& lines,
         std::uint8_t alpha);
 
+/**
+ * @brief computeColor Calculates the color of a set of pixels from their moments. Gives the same result as the per-pixel computeColor.
+ * @param moments The moments of the pixels covered by the scanlines.
+ * @param alpha The alpha of the scanline.
+ * @return The color of the scanlines.
+ */
+geometrize::rgba computeColor(const geometrize::Moments& moments, std::uint8_t alpha);
+
 /**
  * @brief differenceFull Calculates the root-mean-square error between two bitmaps.
  * @param first The first bitmap.
@@ -46,6 +57,15 @@ geometrize::rgba computeColor(
  */
 float differenceFull(const geometrize::Bitmap& first, const geometrize::Bitmap& second);
 
+/**
+ * @brief differenceFull Calculates the root-mean-square error between two bitmaps, splitting the rows between the threads of a pool. Gives the same result as the other differenceFull for any number of threads.
+ * @param first The first bitmap.
+ * @param second The second bitmap.
+ * @param threadPool The thread pool to run on.
+ * @return The difference/error measure between the two bitmaps.
+ */
+float differenceFull(const geometrize::Bitmap& first, const geometrize::Bitmap& second, geometrize::ThreadPool& threadPool);
+
 /**
  * @brief differencePartial Calculates the root-mean-square error between the parts of the two bitmaps within the scanline mask.
  * This is for optimization purposes, it lets us calculate new error values only for parts of the image we know have changed.
@@ -63,6 +83,41 @@ float differencePartial(
         float score,
         const std::vector<Scanline>& lines);
 
+/**
+ * @brief differencePartial Calculates the root-mean-square error that blending a color over the scanlines of a bitmap would result in, without modifying the bitmap.
+ * Gives the same result as drawing the scanlines into a copy of the bitmap with geometrize::drawLines and calling the other differencePartial, but only reads the covered pixels.
+ * @param target The target bitmap.
+ * @param before The bitmap before the change.
+ * @param color The color (including alpha) that would be blended over the scanlines.
+ * @param score The score.
+ * @param lines The scanlines.
+ * @return The difference/error between the target and the blended bitmap.
+ */
+float differencePartial(
+        const geometrize::Bitmap& target,
+        const geometrize::Bitmap& before,
+        geometrize::rgba color,
+        float score,
+        const std::vector<Scanline>& lines);
+
+/**
+ * @brief differencePartial Calculates the root-mean-square error that blending a color over the scanlines of a bitmap would result in, without modifying the bitmap.
+ * @param target The target bitmap.
+ * @param before The bitmap before the change.
+ * @param color The color (including alpha) that would be blended over the scanlines.
+ * @param score The score.
+ * @param lines The scanlines.
+ * @param opaque Whether every pixel of the before bitmap is opaque, which lets the scalar span kernels skip the alpha channel.
+ * @return The difference/error between the target and the blended bitmap.
+ */
+float differencePartial(
+        const geometrize::Bitmap& target,
+        const geometrize::Bitmap& before,
+        geometrize::rgba color,
+        float score,
+        const std::vector<Scanline>& lines,
+        bool opaque);
+
 /**
  * @brief bestRandomState Gets the best state using a random algorithm.
  * @param model The model to query for constraints etc.
@@ -71,7 +126,6 @@ float differencePartial(
  * @param n The number of states to try.
  * @param target The target bitmap.
  * @param current The current bitmap.
- * @param buffer The buffer bitmap.
  * @param lastScore The last score.
  * @return The best random state i.e. the one with the lowest energy.
  */
@@ -82,7 +136,6 @@ geometrize::State bestRandomState(
         std::uint32_t n,
         const geometrize::Bitmap& target,
         const geometrize::Bitmap& current,
-        geometrize::Bitmap& buffer,
         float lastScore);
 
 /**
@@ -91,7 +144,6 @@ geometrize::State bestRandomState(
  * @param maxAge The maximum age.
  * @param target The target bitmap.
  * @param current The current bitmap.
- * @param buffer The buffer bitmap.
  * @param lastScore The last score.
  * @return The best state found from hillclimbing.
  */
@@ -100,7 +152,6 @@ geometrize::State hillClimb(
         std::uint32_t maxAge,
         const geometrize::Bitmap& target,
         const geometrize::Bitmap& current,
-        geometrize::Bitmap& buffer,
         float lastScore);
 
 /**
@@ -112,7 +163,6 @@ geometrize::State hillClimb(
  * @param age The number of hillclimbing steps.
  * @param target The target bitmap.
  * @param current The current bitmap.
- * @param buffer The buffer bitmap.
  * @param lastScore The last score.
  * @return The best state acquired from hill climbing i.e. the one with the lowest energy.
  */
@@ -124,17 +174,33 @@ geometrize::State bestHillClimbState(
         std::uint32_t age,
         const geometrize::Bitmap& target,
         const geometrize::Bitmap& current,
-        geometrize::Bitmap& buffer,
         float lastScore);
 
+/**
+ * @brief energy Calculates a measure of the improvement adding the scanlines of a shape provides - lower energy is better.
+ * The shape is never actually drawn: the blended pixels are computed on the fly and compared against the target, so no scratch bitmap is needed.
+ * @param lines The scanlines of the shape.
+ * @param alpha The alpha of the scanlines.
+ * @param target The target bitmap.
+ * @param current The current bitmap.
+ * @param score The score.
+ * @return The energy measure.
+ */
+float energy(
+        const std::vector<geometrize::Scanline>& lines,
+        std::uint32_t alpha,
+        const geometrize::Bitmap& target,
+        const geometrize::Bitmap& current,
+        float score);
+
 /**
  * @brief energy Calculates a measure of the improvement adding the scanlines of a shape provides - lower energy is better.
  * @param lines The scanlines of the shape.
  * @param alpha The alpha of the scanlines.
  * @param target The target bitmap.
  * @param current The current bitmap.
- * @param buffer The buffer bitmap.
  * @param score The score.
+ * @param opaque Whether every pixel of the current bitmap is opaque, which lets the scalar span kernels skip the alpha channel.
  * @return The energy measure.
  */
 float energy(
@@ -142,7 +208,40 @@ float energy(
         std::uint32_t alpha,
         const geometrize::Bitmap& target,
         const geometrize::Bitmap& current,
-        geometrize::Bitmap& buffer,
+        float score,
+        bool opaque);
+
+/**
+ * @brief energy Calculates a measure of the improvement adding the scanlines of a shape provides - lower energy is better.
+ * Uses precalculated moment tables, so this takes time proportional to the number of scanlines rather than the number of pixels covered.
+ * Blending is modelled without the rounding that geometrize::drawLines does, so the result closely approximates the per-pixel energy function.
+ * @param lines The scanlines of the shape.
+ * @param alpha The alpha of the scanlines.
+ * @param moments The moment tables of the target and current bitmaps.
+ * @param score The score.
+ * @return The energy measure.
+ */
+float energy(
+        const std::vector<geometrize::Scanline>& lines,
+        std::uint32_t alpha,
+        const geometrize::MomentTables& moments,
+        float score);
+
+/**
+ * @brief energy Calculates a measure of the improvement blending a color over a set of pixels provides - lower energy is better.
+ * Blending is modelled without the rounding that geometrize::drawLines does, so the result closely approximates the per-pixel energy function.
+ * @param moments The moments of the pixels covered by the shape.
+ * @param alpha The alpha of the shape.
+ * @param width The width of the target bitmap.
+ * @param height The height of the target bitmap.
+ * @param score The score.
+ * @return The energy measure.
+ */
+float energy(
+        const geometrize::Moments& moments,
+        std::uint32_t alpha,
+        std::uint32_t width,
+        std::uint32_t height,
         float score);
 
 }
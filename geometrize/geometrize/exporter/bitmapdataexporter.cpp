@@ -2,8 +2,10 @@
 
 #include <cstdint>
 #include <sstream>
+#include <vector>
 
 #include "../bitmap/bitmap.h"
+#include "../bitmap/pixelformat.h"
 
 namespace geometrize
 {
@@ -20,6 +22,12 @@ std::string exportBitmapData(const geometrize::Bitmap& bitmapData)
 {
     std::ostringstream stream(std::ios::binary);
 
+    if(bitmapData.getFormat() == geometrize::PixelFormat::GRAY8) {
+        const std::vector<std::uint8_t>& data{bitmapData.getDataRef()};
+        stream.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        return stream.str();
+    }
+
     for(std::uint32_t y = 0U; y < bitmapData.getHeight(); y++) {
         for(std::uint32_t x = 0U; x < bitmapData.getWidth(); x++) {
             const geometrize::rgba pixel(bitmapData.getPixel(x, y));
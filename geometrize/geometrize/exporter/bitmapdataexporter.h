@@ -14,7 +14,7 @@ namespace exporter
 {
 
 /**
- * @brief exportBitmapData Exports the raw image data to a binary dump - just the data as RGBA8888, no zero-padding or anything.
+ * @brief exportBitmapData Exports the raw image data to a binary dump - just the data as RGBA8888, or as GRAY8 for GRAY8 image data, no zero-padding or anything.
  * @param bitmapData The image data to save as binary data.
  * @return A string containing the raw bitmap data.
  */
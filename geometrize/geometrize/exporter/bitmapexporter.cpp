@@ -1,9 +1,11 @@
 #include "bitmapexporter.h"
 
+#include <cstddef>
 #include <cstdint>
 #include <sstream>
 
 #include "../bitmap/bitmap.h"
+#include "../bitmap/pixelformat.h"
 
 namespace geometrize
 {
@@ -52,36 +54,65 @@ inline void writeToStream(std::ostringstream& stream, const std::uint8_t& t)
     stream.write(reinterpret_cast<const char*>(&t), sizeof(std::uint8_t));
 }
 
+const std::uint32_t BITMAP_FILE_HEADER_SIZE{14U};
+const std::uint32_t BITMAP_INFORMATION_HEADER_SIZE{40U};
+const std::uint32_t GRAY_COLOR_TABLE_SIZE{256U * 4U};
+
+geometrize::exporter::BitmapFileSizes getBitmapFileSizes(const std::uint32_t width, const std::uint32_t height, const geometrize::PixelFormat format)
+{
+    // GRAY8 bitmaps are saved as 8-bit images with a gray color table, so each pixel takes one byte instead of three
+    const bool gray{format == geometrize::PixelFormat::GRAY8};
+    const std::uint32_t bytesPerPixel{gray ? 1U : 3U};
+    const std::uint32_t colorTableSize{gray ? GRAY_COLOR_TABLE_SIZE : 0U};
+
+    BitmapFileSizes sizes;
+
+    // Per row pad byte count, used to ensure that each row is a multiple of 4 bytes.
+    sizes.rowBytes = static_cast<std::uint64_t>(width) * bytesPerPixel;
+    sizes.padding = (sizes.rowBytes % 4 != 0) ? static_cast<std::uint32_t>(4 - (sizes.rowBytes % 4)) : 0;
+    sizes.dataOffset = BITMAP_INFORMATION_HEADER_SIZE + BITMAP_FILE_HEADER_SIZE + colorTableSize;
+
+    // The sizes are worked out in 64 bits, since the image data of large bitmaps can exceed 4 GiB.
+    // The size fields of the format are only 32 bits, so they are set to zero when the sizes do not fit, and readers go by the width, height and bit count instead.
+    const std::uint64_t fullImageSize{(sizes.rowBytes + sizes.padding) * height};
+    const std::uint64_t fullFileSize{sizes.dataOffset + fullImageSize};
+    const bool sizesFit{fullFileSize <= UINT32_MAX};
+    sizes.imageSize = sizesFit ? static_cast<std::uint32_t>(fullImageSize) : 0U;
+    sizes.fileSize = sizesFit ? static_cast<std::uint32_t>(fullFileSize) : 0U;
+    return sizes;
+}
+
 std::string exportBMP(const geometrize::Bitmap& bitmapData)
 {
     std::ostringstream stream(std::ios::binary);
 
-    const std::uint32_t BITMAP_FILE_HEADER_SIZE{14U};
-    const std::uint32_t BITMAP_INFORMATION_HEADER_SIZE{40U};
+    const bool gray{bitmapData.getFormat() == geometrize::PixelFormat::GRAY8};
+    const std::uint32_t bytesPerPixel{gray ? 1U : 3U};
+    const std::uint32_t COLOR_TABLE_SIZE{gray ? GRAY_COLOR_TABLE_SIZE : 0U};
 
     const std::uint32_t width{bitmapData.getWidth()}; // The width of the image in pixels.
     const std::uint32_t height{bitmapData.getHeight()}; // The height of the image in pixels.
 
-    // Per row pad byte count, used to ensure that each row is a multiple of 4 bytes.
-    const std::uint32_t padding{ ((width * 3) % 4 != 0) ? 4 - ((width * 3) % 4) : 0};
+    const geometrize::exporter::BitmapFileSizes sizes{getBitmapFileSizes(width, height, bitmapData.getFormat())};
+    const std::uint32_t padding{sizes.padding};
 
     // Bitmap Information Header
     const std::uint32_t ifSize{BITMAP_INFORMATION_HEADER_SIZE}; // The number of bytes required by the structure.
     const std::uint16_t planes{1U}; // The number of planes for the target device. This value must be set to 1.
-    const std::uint16_t bitCount{24U}; // The number of bits that define each pixel and the maximum number of colors in the bitmap.
+    const std::uint16_t bitCount{static_cast<std::uint16_t>(bytesPerPixel * 8U)}; // The number of bits that define each pixel and the maximum number of colors in the bitmap.
     const std::uint32_t compression{0U}; // Specifies the bitmap compression type.
-    const std::uint32_t imageSize{(((width * 3U) + padding) & 0x0000FFFC) * height}; // The size of the image in bytes.
+    const std::uint32_t imageSize{sizes.imageSize}; // The size of the image in bytes.
     const std::uint32_t xPelsPerMeter{0U}; // The horizontal resolution in pixels-per-meter.
     const std::uint32_t yPelsPerMeter{0U}; // The vertical resolution in pixels-per-meter.
-    const std::uint32_t colorsUsed{0U}; // The number of color indexes in the color table actually used by the bitmap.
+    const std::uint32_t colorsUsed{COLOR_TABLE_SIZE / 4U}; // The number of color indexes in the color table actually used by the bitmap.
     const std::uint32_t colorsImportant{0U}; // The number of color indexes required for displaying the bitmap. If zero, all colors are required.
 
     // Bitmap File Header
     const std::uint16_t type{19778U}; // The file type.
-    const std::uint32_t fhSize{BITMAP_INFORMATION_HEADER_SIZE + BITMAP_FILE_HEADER_SIZE + imageSize}; // The size in bytes of the bitmap file.
+    const std::uint32_t fhSize{sizes.fileSize}; // The size in bytes of the bitmap file.
     const std::uint16_t reserved1{0U}; // Reserved, must be zero.
     const std::uint16_t reserved2{0U}; // Reserved, must be zero.
-    const std::uint32_t offbits{BITMAP_INFORMATION_HEADER_SIZE + BITMAP_FILE_HEADER_SIZE}; // The offset, in bytes, from the beginning of the BitmapFileHeader structure to the bitmap bits.
+    const std::uint32_t offbits{sizes.dataOffset}; // The offset, in bytes, from the beginning of the BitmapFileHeader structure to the bitmap bits.
 
     writeToStream(stream, type);
     writeToStream(stream, fhSize);
@@ -101,13 +132,28 @@ std::string exportBMP(const geometrize::Bitmap& bitmapData)
     writeToStream(stream, colorsUsed);
     writeToStream(stream, colorsImportant);
 
+    // Color Table, blue, green, red and a reserved byte for each gray level
+    for(std::uint32_t i = 0U; i < colorsUsed; i++) {
+        const std::uint8_t level{static_cast<std::uint8_t>(i)};
+        const std::uint8_t reserved{0U};
+        writeToStream(stream, level);
+        writeToStream(stream, level);
+        writeToStream(stream, level);
+        writeToStream(stream, reserved);
+    }
+
     // Bitmap Image Data
+    const std::uint8_t* data{bitmapData.getDataRef().data()};
     for(std::uint32_t y = 0U; y < bitmapData.getHeight(); y++) {
-        for(std::uint32_t x = 0U; x < bitmapData.getWidth(); x++) {
-            const geometrize::rgba pixel(bitmapData.getPixel(x, y));
-            writeToStream(stream, pixel.b);
-            writeToStream(stream, pixel.g);
-            writeToStream(stream, pixel.r);
+        if(gray) {
+            stream.write(reinterpret_cast<const char*>(data + static_cast<std::size_t>(y) * width), width);
+        } else {
+            for(std::uint32_t x = 0U; x < bitmapData.getWidth(); x++) {
+                const geometrize::rgba pixel(bitmapData.getPixel(x, y));
+                writeToStream(stream, pixel.b);
+                writeToStream(stream, pixel.g);
+                writeToStream(stream, pixel.r);
+            }
         }
         for (std::uint32_t pad = 0U; pad < padding; pad++) {
             const std::uint8_t zeroPad{0U};
@@ -1,7 +1,10 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 
+#include "../bitmap/pixelformat.h"
+
 namespace geometrize
 {
 class Bitmap;
@@ -14,7 +17,31 @@ namespace exporter
 {
 
 /**
- * @brief exportBMP Exports the image data to a RGB888 bitmap image file (BMP).
+ * @brief The BitmapFileSizes struct holds the sizes that exportBMP writes to the headers of a bitmap image file, and the padding it adds to each row of the image data.
+ * @author Sam Twidale (http://samcodes.co.uk/)
+ */
+struct BitmapFileSizes
+{
+    std::uint64_t rowBytes; ///< The number of bytes of image data in each row, not counting the padding.
+    std::uint32_t padding; ///< The number of zero bytes added to the end of each row, so that rows are a multiple of 4 bytes long.
+    std::uint32_t dataOffset; ///< The offset of the image data from the start of the file, in bytes.
+    std::uint32_t imageSize; ///< The size of the image data in bytes, or zero if the file is over 4 GiB.
+    std::uint32_t fileSize; ///< The size of the file in bytes, or zero if the file is over 4 GiB.
+};
+
+/**
+ * @brief getBitmapFileSizes Works out the sizes of the bitmap image file that exportBMP makes for an image of the given size and format.
+ * The sizes are worked out in 64 bits, so this is correct for images whose data exceeds 4 GiB.
+ * @param width The width of the image in pixels.
+ * @param height The height of the image in pixels.
+ * @param format The format of the image data. GRAY8 images are saved as 8-bit images with a color table, other formats as 24-bit images.
+ * @return The sizes of the bitmap image file.
+ */
+geometrize::exporter::BitmapFileSizes getBitmapFileSizes(std::uint32_t width, std::uint32_t height, geometrize::PixelFormat format);
+
+/**
+ * @brief exportBMP Exports the image data to a RGB888 bitmap image file (BMP), or to an 8-bit grayscale bitmap image file for GRAY8 image data.
+ * The file and image size fields of the header are left at zero for images over 4 GiB, which they cannot hold.
  * @param bitmapData The image data to save as a bitmap image file.
  * @return A string containing the bitmap data.
  */
@@ -3,19 +3,24 @@
 #include <algorithm>
 #include <atomic>
 #include <cassert>
+#include <cstddef>
 #include <cstdint>
-#include <future>
 #include <memory>
+#include <thread>
+#include <utility>
 #include <vector>
 
 #include "bitmap/bitmap.h"
+#include "bitmap/bitmapview.h"
 #include "commonutil.h"
 #include "core.h"
+#include "momenttables.h"
 #include "rasterizer/rasterizer.h"
 #include "shape/shape.h"
 #include "shaperesult.h"
 #include "shape/shapemutator.h"
 #include "shape/shapetypes.h"
+#include "threadpool.h"
 
 namespace geometrize
 {
@@ -23,25 +28,34 @@ namespace geometrize
 class Model::ModelImpl
 {
 public:
-    ModelImpl(geometrize::Model* pQ, const geometrize::Bitmap& target) :
+    ModelImpl(geometrize::Model* pQ, geometrize::Bitmap&& target) :
         q{pQ},
-        m_target{target},
-        m_current{target.getWidth(), target.getHeight(), geometrize::commonutil::getAverageImageColor(m_target)},
-        m_lastScore{geometrize::core::differenceFull(m_target, m_current)},
+        m_threadPool{createStartupThreadPool(target)},
+        m_ownsThreadPool{m_threadPool != nullptr},
+        m_target{std::move(target)},
+        m_current{m_target.getWidth(), m_target.getHeight(), getAverageTargetColor(), m_target.getFormat()},
+        m_opaque{true},
+        m_lastScore{differenceFull()},
         m_baseRandomSeed{0U},
-        m_randomSeedOffset{0U}
+        m_stepCount{0U},
+        m_candidateBatches{0U}
     {}
 
-    ModelImpl(geometrize::Model* pQ, const geometrize::Bitmap& target, const geometrize::Bitmap& initial) :
+    ModelImpl(geometrize::Model* pQ, geometrize::Bitmap&& target, geometrize::Bitmap&& initial) :
         q{pQ},
-        m_target{target},
-        m_current{initial},
-        m_lastScore{geometrize::core::differenceFull(m_target, m_current)},
+        m_threadPool{createStartupThreadPool(target)},
+        m_ownsThreadPool{m_threadPool != nullptr},
+        m_target{std::move(target)},
+        m_current{std::move(initial)},
+        m_opaque{geometrize::commonutil::isOpaque(m_current)},
+        m_lastScore{differenceFull()},
         m_baseRandomSeed{0U},
-        m_randomSeedOffset{0U}
+        m_stepCount{0U},
+        m_candidateBatches{0U}
     {
         assert(m_target.getWidth() == m_current.getWidth());
         assert(m_target.getHeight() == m_current.getHeight());
+        assert(m_target.getFormat() == m_current.getFormat());
     }
 
     ~ModelImpl() = default;
@@ -51,7 +65,12 @@ public:
     void reset(const geometrize::rgba backgroundColor)
     {
         m_current.fill(backgroundColor);
-        m_lastScore = geometrize::core::differenceFull(m_target, m_current);
+        m_opaque = geometrize::commonutil::isOpaque(m_current);
+        m_lastScore = differenceFull();
+        m_stepCount = 0U;
+        if(m_moments) {
+            m_moments->update(m_target, m_current);
+        }
     }
 
     std::int32_t getWidth() const
@@ -64,12 +83,31 @@ public:
         return m_target.getHeight();
     }
 
-    std::vector<geometrize::State> getHillClimbState(
-            const geometrize::ShapeTypes shapeTypes,
-            const std::uint8_t alpha,
-            const std::uint32_t shapeCount,
-            const std::uint32_t maxShapeMutations,
-            std::uint32_t maxThreads)
+    static std::shared_ptr<geometrize::ThreadPool> createStartupThreadPool(const geometrize::Bitmap& target)
+    {
+        // Large targets are split between worker threads while the model is set up, the pool is then kept for stepping
+        if(static_cast<std::size_t>(target.getWidth()) * target.getHeight() < parallelPixelThreshold) {
+            return nullptr;
+        }
+        return std::make_shared<geometrize::ThreadPool>(0U);
+    }
+
+    bool isParallel() const
+    {
+        return m_threadPool && static_cast<std::size_t>(m_target.getWidth()) * m_target.getHeight() >= parallelPixelThreshold;
+    }
+
+    geometrize::rgba getAverageTargetColor() const
+    {
+        return isParallel() ? geometrize::commonutil::getAverageImageColor(m_target, *m_threadPool) : geometrize::commonutil::getAverageImageColor(m_target);
+    }
+
+    float differenceFull() const
+    {
+        return isParallel() ? geometrize::core::differenceFull(m_target, m_current, *m_threadPool) : geometrize::core::differenceFull(m_target, m_current);
+    }
+
+    std::uint32_t ensureThreadPool(std::uint32_t maxThreads)
     {
         // Ensure that the maximum number of threads is a sane value
         if(maxThreads == 0) {
@@ -80,27 +118,98 @@ public:
             }
         }
 
-        std::vector<std::future<geometrize::State>> futures{maxThreads};
-        for(std::uint32_t i = 0; i < futures.size(); i++) {
-            std::future<geometrize::State> handle{std::async(std::launch::async, [&](const std::uint32_t seed, const float lastScore) {
-                // Ensure that the results of the random generation are the same between tasks with identical settings
-                // The RNG is thread-local and std::async may use a thread pool (which is why this is necessary)
-                // Note this implementation requires maxThreads to be the same between tasks for each task to produce the same results.
-                geometrize::commonutil::seedRandomGenerator(seed);
-
-                geometrize::Bitmap buffer{m_current};
-                return core::bestHillClimbState(*q, shapeTypes, alpha, shapeCount, maxShapeMutations, m_target, m_current, buffer, lastScore);
-            }, m_baseRandomSeed + m_randomSeedOffset++, m_lastScore)};
-            futures[i] = std::move(handle);
+        // Keep the worker threads alive between steps, only recreating them if the number of threads changes
+        if(!m_threadPool || (m_ownsThreadPool && m_threadPool->getThreadCount() != maxThreads)) {
+            m_threadPool.reset();
+            m_threadPool = std::make_shared<geometrize::ThreadPool>(maxThreads);
+            m_ownsThreadPool = true;
         }
+        return maxThreads;
+    }
 
-        std::vector<geometrize::State> states;
-        for(auto& f : futures) {
-            states.emplace_back(f.get());
-        }
+    std::vector<geometrize::State> getHillClimbState(
+            const geometrize::ShapeTypes shapeTypes,
+            const std::uint8_t alpha,
+            const std::uint32_t shapeCount,
+            const std::uint32_t maxShapeMutations,
+            std::uint32_t maxThreads)
+    {
+        maxThreads = ensureThreadPool(maxThreads);
+
+        // Each task is seeded from the step and its index, so the results do not depend on which worker thread runs it
+        // Note that every task tries shapeCount random shapes, so maxThreads must be the same between runs for them to produce the same results
+        // Use candidate batches for results that do not depend on the number of threads
+        const std::uint32_t seed{m_baseRandomSeed};
+        const std::uint32_t step{m_stepCount++};
+        const float lastScore{m_lastScore};
+
+        std::vector<geometrize::State> states(maxThreads);
+        m_threadPool->run(maxThreads, [&](const std::uint32_t task, const std::uint32_t) {
+            // The RNG is thread-local and the pool threads are reused, so it must be reseeded for every task
+            geometrize::commonutil::seedRandomGenerator(geometrize::commonutil::deriveSeed(seed, step, task));
+
+            states[task] = core::bestHillClimbState(*q, shapeTypes, alpha, shapeCount, maxShapeMutations, m_target, m_current, lastScore);
+        });
+        return states;
+    }
+
+    std::vector<geometrize::State> getBatchedHillClimbState(
+            const geometrize::ShapeTypes shapeTypes,
+            const std::uint8_t alpha,
+            const std::uint32_t shapeCount,
+            const std::uint32_t maxShapeMutations,
+            const std::uint32_t maxThreads)
+    {
+        ensureThreadPool(maxThreads);
+
+        // Split the random shapes between the batches as evenly as possible, every batch needs at least one
+        // At least one random shape is tried even if none are asked for, like bestRandomState does, so every batch has a shape to hill climb
+        const std::uint32_t candidateCount{(std::max)(1U, shapeCount)};
+        const std::uint32_t batchCount{(std::max)(1U, (std::min)(m_candidateBatches, candidateCount))};
+        const std::uint32_t seed{m_baseRandomSeed};
+        const std::uint32_t step{m_stepCount++};
+        const float lastScore{m_lastScore};
+
+        // The workers take batches in order from the pool's shared queue until there are none left
+        std::vector<geometrize::State> states(batchCount);
+        m_threadPool->run(batchCount, [&](const std::uint32_t batch, const std::uint32_t) {
+            const std::uint32_t first{static_cast<std::uint32_t>(static_cast<std::uint64_t>(candidateCount) * batch / batchCount)};
+            const std::uint32_t last{static_cast<std::uint32_t>(static_cast<std::uint64_t>(candidateCount) * (batch + 1U) / batchCount)};
+            states[batch] = hillClimbCandidates(shapeTypes, alpha, candidateCount, first, last, maxShapeMutations, seed, step, lastScore);
+        });
         return states;
     }
 
+    geometrize::State hillClimbCandidates(
+            const geometrize::ShapeTypes shapeTypes,
+            const std::uint8_t alpha,
+            const std::uint32_t shapeCount,
+            const std::uint32_t firstCandidate,
+            const std::uint32_t lastCandidate,
+            const std::uint32_t maxShapeMutations,
+            const std::uint32_t seed,
+            const std::uint32_t step,
+            const float lastScore)
+    {
+        // Every random shape is seeded from its own index, so the shapes tried do not depend on the threads or batches used
+        assert(firstCandidate < lastCandidate);
+        geometrize::State bestState;
+        std::uint32_t bestCandidate{firstCandidate};
+        for(std::uint32_t candidate = firstCandidate; candidate < lastCandidate; candidate++) {
+            geometrize::commonutil::seedRandomGenerator(geometrize::commonutil::deriveSeed(seed, step, candidate));
+            geometrize::State state(*q, shapeTypes, alpha);
+            state.calculateEnergy(m_target, m_current, lastScore);
+            if(candidate == firstCandidate || state.m_score < bestState.m_score) {
+                bestState = state;
+                bestCandidate = candidate;
+            }
+        }
+
+        // The hill climb is seeded from the index of the shape it starts from, using indices after those of the random shapes
+        geometrize::commonutil::seedRandomGenerator(geometrize::commonutil::deriveSeed(seed, step, shapeCount + bestCandidate));
+        return core::hillClimb(bestState, maxShapeMutations, m_target, m_current, lastScore);
+    }
+
     std::vector<geometrize::ShapeResult> step(
             const geometrize::ShapeTypes shapeTypes,
             const std::uint8_t alpha,
@@ -108,12 +217,15 @@ public:
             const std::uint32_t maxShapeMutations,
             const std::uint32_t maxThreads)
     {
-        std::vector<geometrize::State> states{getHillClimbState(shapeTypes, alpha, shapeCount, maxShapeMutations, maxThreads)};
+        std::vector<geometrize::State> states{m_candidateBatches == 0 ?
+                    getHillClimbState(shapeTypes, alpha, shapeCount, maxShapeMutations, maxThreads) :
+                    getBatchedHillClimbState(shapeTypes, alpha, shapeCount, maxShapeMutations, maxThreads)};
         if(states.empty()) {
             assert(0 && "Failed to get a hill climb state");
             return {};
         }
 
+        // Ties go to the earliest task, so the result does not depend on the order the tasks finished in
         std::vector<geometrize::State>::iterator it = std::min_element(states.begin(), states.end(), [](const geometrize::State& a, const geometrize::State& b) {
             return a.m_score < b.m_score;
         });
@@ -128,10 +240,13 @@ public:
     {
         const std::vector<geometrize::Scanline> lines{shape->rasterize()};
         const geometrize::rgba color(geometrize::core::computeColor(m_target, m_current, lines, alpha));
-        const geometrize::Bitmap before{m_current};
-        geometrize::drawLines(m_current, color, lines);
 
-        m_lastScore = geometrize::core::differencePartial(m_target, before, m_current, m_lastScore, lines);
+        // Score the shape before drawing it, so the pixels under it do not need to be kept around
+        m_lastScore = geometrize::core::differencePartial(m_target, m_current, color, m_lastScore, lines, m_opaque);
+        geometrize::drawLines(m_current, color, lines, m_opaque);
+        if(m_moments) {
+            m_moments->updateRows(m_target, m_current, lines);
+        }
 
         const geometrize::ShapeResult result{m_lastScore, color, shape};
         return result;
@@ -142,10 +257,11 @@ public:
             const geometrize::rgba color)
     {
         const std::vector<geometrize::Scanline> lines{shape->rasterize()};
-        const geometrize::Bitmap before{m_current};
-        geometrize::drawLines(m_current, color, lines);
-
-        m_lastScore = geometrize::core::differencePartial(m_target, before, m_current, m_lastScore, lines);
+        m_lastScore = geometrize::core::differencePartial(m_target, m_current, color, m_lastScore, lines, m_opaque);
+        geometrize::drawLines(m_current, color, lines, m_opaque);
+        if(m_moments) {
+            m_moments->updateRows(m_target, m_current, lines);
+        }
 
         const geometrize::ShapeResult result{m_lastScore, color, shape};
         return result;
@@ -176,6 +292,46 @@ public:
         m_baseRandomSeed = seed;
     }
 
+    void setCandidateBatchCount(const std::uint32_t batchCount)
+    {
+        m_candidateBatches = batchCount;
+    }
+
+    std::uint32_t getCandidateBatchCount() const
+    {
+        return m_candidateBatches;
+    }
+
+    void setMomentTablesEnabled(const bool enabled)
+    {
+        if(!enabled) {
+            m_moments.reset();
+        } else if(!m_moments) {
+            m_moments.reset(new geometrize::MomentTables(m_target, m_current));
+        }
+    }
+
+    const geometrize::MomentTables* getMomentTables() const
+    {
+        return m_moments.get();
+    }
+
+    bool isOpaque() const
+    {
+        return m_opaque;
+    }
+
+    void setThreadPool(const std::shared_ptr<geometrize::ThreadPool> threadPool)
+    {
+        m_threadPool = threadPool;
+        m_ownsThreadPool = false;
+    }
+
+    std::shared_ptr<geometrize::ThreadPool> getThreadPool() const
+    {
+        return m_threadPool;
+    }
+
     const geometrize::ShapeMutator& getShapeMutator() const
     {
         return m_shapeMutator;
@@ -188,19 +344,34 @@ public:
 
 private:
     geometrize::Model* q;
+    std::shared_ptr<geometrize::ThreadPool> m_threadPool; ///< The worker threads used for model stepping. Null until the model is first stepped, unless one is set by the user or the target is large enough to be split between threads when the model is created.
+    bool m_ownsThreadPool; ///< Whether the thread pool was created by the model (rather than set by the user), in which case it is resized to match the number of threads requested.
     geometrize::Bitmap m_target; ///< The target bitmap, the bitmap we aim to approximate.
     geometrize::Bitmap m_current; ///< The current bitmap.
+    bool m_opaque; ///< Whether every pixel of the current bitmap is opaque. Drawing shapes keeps opaque pixels opaque, so this is only worked out when the model is created or reset.
     float m_lastScore; ///< Score derived from calculating the difference between bitmaps.
     const static std::uint32_t defaultMaxThreads{4};
+    const static std::size_t parallelPixelThreshold{1U << 20}; ///< The number of pixels from which whole-bitmap work such as differenceFull is split between threads.
     std::atomic<std::uint32_t> m_baseRandomSeed; ///< The base value used for seeding the random number generator (the one the user has control over).
-    std::atomic<std::uint32_t> m_randomSeedOffset; ///< Seed used for random number generation. Note: incremented by each std::async call used for model stepping.
+    std::uint32_t m_stepCount; ///< The number of times the model has been stepped since it was created or reset, used with the base seed to derive the seeds for each step.
     geometrize::ShapeMutator m_shapeMutator; ///< Object responsible for setting up and mutating shapes created by this model.
+    std::unique_ptr<geometrize::MomentTables> m_moments; ///< Moment tables of the target and current bitmaps, used to speed up scoring candidate shapes. Null when disabled.
+    std::uint32_t m_candidateBatches; ///< The number of batches the random shapes are split into when stepping, 0 to have every thread work through all of them instead.
 };
 
-Model::Model(const geometrize::Bitmap& target) : d{std::unique_ptr<Model::ModelImpl>(new Model::ModelImpl(this, target))}
+Model::Model(const geometrize::Bitmap& target) : d{std::unique_ptr<Model::ModelImpl>(new Model::ModelImpl(this, geometrize::Bitmap(target)))}
+{}
+
+Model::Model(geometrize::Bitmap&& target) : d{std::unique_ptr<Model::ModelImpl>(new Model::ModelImpl(this, std::move(target)))}
+{}
+
+Model::Model(const geometrize::BitmapView& target) : d{std::unique_ptr<Model::ModelImpl>(new Model::ModelImpl(this, geometrize::Bitmap(target)))}
 {}
 
-Model::Model(const geometrize::Bitmap& target, const geometrize::Bitmap& initial) : d{std::unique_ptr<Model::ModelImpl>(new Model::ModelImpl(this, target, initial))}
+Model::Model(const geometrize::Bitmap& target, const geometrize::Bitmap& initial) : d{std::unique_ptr<Model::ModelImpl>(new Model::ModelImpl(this, geometrize::Bitmap(target), geometrize::Bitmap(initial)))}
+{}
+
+Model::Model(geometrize::Bitmap&& target, geometrize::Bitmap&& initial) : d{std::unique_ptr<Model::ModelImpl>(new Model::ModelImpl(this, std::move(target), std::move(initial)))}
 {}
 
 Model::~Model()
@@ -266,6 +437,41 @@ void Model::setSeed(const std::uint32_t seed)
     d->setSeed(seed);
 }
 
+void Model::setCandidateBatchCount(const std::uint32_t batchCount)
+{
+    d->setCandidateBatchCount(batchCount);
+}
+
+std::uint32_t Model::getCandidateBatchCount() const
+{
+    return d->getCandidateBatchCount();
+}
+
+void Model::setMomentTablesEnabled(const bool enabled)
+{
+    d->setMomentTablesEnabled(enabled);
+}
+
+const geometrize::MomentTables* Model::getMomentTables() const
+{
+    return d->getMomentTables();
+}
+
+bool Model::isOpaque() const
+{
+    return d->isOpaque();
+}
+
+void Model::setThreadPool(const std::shared_ptr<geometrize::ThreadPool> threadPool)
+{
+    d->setThreadPool(threadPool);
+}
+
+std::shared_ptr<geometrize::ThreadPool> Model::getThreadPool() const
+{
+    return d->getThreadPool();
+}
+
 const geometrize::ShapeMutator& Model::getShapeMutator() const
 {
     return d->getShapeMutator();
@@ -11,7 +11,11 @@
 namespace geometrize
 {
 class Bitmap;
+class BitmapView;
+class MomentTables;
 class Shape;
+class ShapeUndo;
+class ThreadPool;
 }
 
 namespace geometrize
@@ -19,6 +23,8 @@ namespace geometrize
 
 /**
  * @brief The Model class is the model for the core optimization/fitting algorithm.
+ * Given a GRAY8 target bitmap, the model works in luminance only: the current bitmap is GRAY8 too, the shapes are given gray colors,
+ * and the results and scores are the same as those of a model of the target expanded to opaque RGBA, for a quarter of the memory and scoring work.
  * @author Sam Twidale (http://samcodes.co.uk/)
  */
 class Model
@@ -30,19 +36,42 @@ public:
      */
     Model(const geometrize::Bitmap& target);
 
+    /**
+     * @brief Model Creates a model that will aim to replicate the target bitmap with shapes, taking the target bitmap's data instead of copying it.
+     * @param target The target bitmap to replicate with shapes.
+     */
+    Model(geometrize::Bitmap&& target);
+
+    /**
+     * @brief Model Creates a model that will aim to replicate the target pixel data with shapes, such as a frame held by an image decoder.
+     * The pixels are converted to RGBA8888 as they are copied into the model's target bitmap, so this takes a single pass over them whatever their format and row stride.
+     * To model the pixels in luminance only, create the target from the view with geometrize::PixelFormat::GRAY8 instead.
+     * @param target The view of the target pixel data to replicate with shapes.
+     */
+    Model(const geometrize::BitmapView& target);
+
     /**
      * @brief Model Creates a model that will optimize for the given target bitmap, starting from the given initial bitmap.
-     * The target bitmap and initial bitmap must be the same size (width and height).
+     * The target bitmap and initial bitmap must be the same size (width and height) and format.
      * @param target The target bitmap to replicate with shapes.
      * @param initial The starting bitmap.
      */
     Model(const geometrize::Bitmap& target, const geometrize::Bitmap& initial);
+
+    /**
+     * @brief Model Creates a model that will optimize for the given target bitmap, starting from the given initial bitmap, taking the bitmaps' data instead of copying it.
+     * The target bitmap and initial bitmap must be the same size (width and height) and format.
+     * @param target The target bitmap to replicate with shapes.
+     * @param initial The starting bitmap.
+     */
+    Model(geometrize::Bitmap&& target, geometrize::Bitmap&& initial);
     ~Model();
     Model& operator=(const Model&) = delete;
     Model(const Model&) = delete;
 
     /**
      * @brief reset Resets the model back to the state it was in when it was created.
+     * If moment tables are enabled, they are rebuilt for the reset bitmap.
      * @param backgroundColor The starting background color to use.
      */
     void reset(geometrize::rgba backgroundColor);
@@ -65,7 +94,8 @@ public:
      * @param alpha The alpha of the shape.
      * @param shapeCount The number of random shapes to generate (only 1 is chosen in the end).
      * @param maxShapeMutations The maximum number of times to mutate each random shape.
-     * @param maxThreads The maximum number of threads to use during this step.
+     * @param maxThreads The maximum number of threads to use during this step. Unless candidate batches are enabled, each thread hill climbs its own set of shapeCount random shapes.
+     * The threads are kept in a pool that is reused between steps, see setThreadPool and setCandidateBatchCount.
      * @return A vector containing data about the shapes added to the model in this step.
      */
     std::vector<geometrize::ShapeResult> step(
@@ -116,11 +146,69 @@ public:
     const geometrize::Bitmap& getTarget() const;
 
     /**
-     * @brief setSeed Sets the seed that the random number generators of this model use. Note that the model also uses an internal seed offset which is incremented when the model is stepped.
+     * @brief setSeed Sets the seed that the random number generators of this model use.
+     * The seeds used in each step are derived from this seed, the number of steps taken since the model was created or reset, and the index of the task or random shape they are used for.
+     * With candidate batches enabled the results are the same for any number of threads, otherwise maxThreads must also be the same to reproduce them, see setCandidateBatchCount.
      * @param seed The random number generator seed.
      */
     void setSeed(std::uint32_t seed);
 
+    /**
+     * @brief setCandidateBatchCount Sets how the random shapes tried in each step are shared between threads.
+     * By default (0) every thread generates shapeCount random shapes and hill climbs the best of them, so adding threads adds work rather than reducing the time taken.
+     * Otherwise the shapeCount random shapes are split between this many batches, and the best shape of each batch is hill climbed. The threads take batches until none are left,
+     * so the total work per step is fixed and adding threads reduces the time taken, as long as there are at least as many batches as threads.
+     * Each random shape and hill climb is seeded by its index rather than by the thread that runs it, so the results are the same for any number of threads.
+     * @param batchCount The number of batches to split the random shapes into, or 0 to have every thread try shapeCount random shapes.
+     */
+    void setCandidateBatchCount(std::uint32_t batchCount);
+
+    /**
+     * @brief getCandidateBatchCount Gets the number of batches the random shapes tried in each step are split into.
+     * @return The number of batches, or 0 if every thread tries shapeCount random shapes.
+     */
+    std::uint32_t getCandidateBatchCount() const;
+
+    /**
+     * @brief setMomentTablesEnabled Sets whether the model keeps moment tables of the target and current bitmaps.
+     * When enabled, candidate shapes are scored in time proportional to their number of scanlines instead of the number of pixels they cover,
+     * and rectangles are scored a band of 16 rows at a time instead of pixel by pixel. This uses an extra 53.5 bytes of memory per pixel, 48 for the row sums (8 32-bit channel sums and 2 64-bit products) and 5.5 for the block sums (11 64-bit moments) of each band of 16 rows,
+     * and the scores closely approximate (rather than exactly match) the per-pixel scores.
+     * The tables store all four RGBA channels whatever the pixel format, so they take as much memory for GRAY8 bitmaps as for RGBA8888 ones, GRAY8 gives no memory saving here.
+     * Note that the tables are only kept up to date by the model itself, and reset rebuilds them, so disable and re-enable them after modifying the current bitmap directly.
+     * @param enabled Whether to enable the moment tables.
+     */
+    void setMomentTablesEnabled(bool enabled);
+
+    /**
+     * @brief getMomentTables Gets the moment tables of the target and current bitmaps.
+     * @return The moment tables, or nullptr if they are not enabled.
+     */
+    const geometrize::MomentTables* getMomentTables() const;
+
+    /**
+     * @brief isOpaque Gets whether every pixel of the current bitmap is opaque, in which case the scalar span kernels skip the alpha channel when scoring and drawing shapes.
+     * Drawing shapes keeps opaque pixels opaque, so this is only worked out when the model is created or reset.
+     * Note that it is not updated when the current bitmap is modified directly, so reset the model after making its pixels translucent.
+     * @return True if every pixel of the current bitmap is opaque, else false.
+     */
+    bool isOpaque() const;
+
+    /**
+     * @brief setThreadPool Sets the thread pool the model uses when stepping, so the worker threads can be shared between models.
+     * By default the model creates its own pool the first time it is stepped (or when it is created, if the target is large enough to split between threads), and recreates it if the number of threads requested changes.
+     * A pool set here is used as-is, however many threads are requested, and passing nullptr makes the model go back to creating its own.
+     * The model's own pool is shut down when the model is destroyed or the pool is replaced, a shared pool is shut down when its last owner releases it.
+     * @param threadPool The thread pool to use.
+     */
+    void setThreadPool(std::shared_ptr<geometrize::ThreadPool> threadPool);
+
+    /**
+     * @brief getThreadPool Gets the thread pool the model uses when stepping.
+     * @return The thread pool, or nullptr if the model has not created one yet and no pool was set.
+     */
+    std::shared_ptr<geometrize::ThreadPool> getThreadPool() const;
+
     /**
      * @brief getShapeMutator Gets the object the model uses for setting up/mutating shapes.
      * @return The shape mutator.
@@ -153,6 +241,17 @@ public:
         getShapeMutator().mutate(shape);
     }
 
+    /**
+     * @brief mutateShape Mutates the given shape, recording the changes made so they can be reverted.
+     * @param shape The shape to mutate.
+     * @param undo The record of the changes made.
+     */
+    template<typename T>
+    void mutateShape(T& shape, geometrize::ShapeUndo& undo) const
+    {
+        getShapeMutator().mutate(shape, undo);
+    }
+
     /**
      * @brief setShapeSetupFunction Sets the setup function for the type of shape passed as a parameter in the passed function.
      * @param func The shape setup function to use for the type of shape this function accepts.
@@ -0,0 +1,197 @@
+#include "momenttables.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#include "bitmap/bitmap.h"
+#include "bitmap/rgba.h"
+#include "rasterizer/scanline.h"
+
+namespace geometrize
+{
+
+inline void add(geometrize::Moments& sum, const geometrize::RowMoments& moments, const std::int64_t count)
+{
+    for(std::size_t i = 0; i < 4U; i++) {
+        sum.target[i] += moments.target[i];
+        sum.current[i] += moments.current[i];
+    }
+    sum.targetCurrent += moments.targetCurrent;
+    sum.currentSquared += moments.currentSquared;
+    sum.count += count;
+}
+
+inline void addDifference(geometrize::Moments& sum, const geometrize::Moments& last, const geometrize::Moments& first)
+{
+    for(std::size_t i = 0; i < 4U; i++) {
+        sum.target[i] += last.target[i] - first.target[i];
+        sum.current[i] += last.current[i] - first.current[i];
+    }
+    sum.targetCurrent += last.targetCurrent - first.targetCurrent;
+    sum.currentSquared += last.currentSquared - first.currentSquared;
+    sum.count += last.count - first.count;
+}
+
+inline void addDifference(geometrize::Moments& sum, const geometrize::RowMoments& last, const geometrize::RowMoments& first, const std::int64_t count)
+{
+    for(std::size_t i = 0; i < 4U; i++) {
+        sum.target[i] += static_cast<std::int64_t>(last.target[i]) - static_cast<std::int64_t>(first.target[i]);
+        sum.current[i] += static_cast<std::int64_t>(last.current[i]) - static_cast<std::int64_t>(first.current[i]);
+    }
+    sum.targetCurrent += last.targetCurrent - first.targetCurrent;
+    sum.currentSquared += last.currentSquared - first.currentSquared;
+    sum.count += count;
+}
+
+MomentTables::MomentTables(const geometrize::Bitmap& target, const geometrize::Bitmap& current) :
+    m_width{target.getWidth()},
+    m_height{target.getHeight()},
+    m_rows(static_cast<std::size_t>(target.getWidth() + 1U) * target.getHeight(), geometrize::RowMoments{}),
+    m_blocks(static_cast<std::size_t>(target.getWidth() + 1U) * (target.getHeight() / blockRows), geometrize::Moments{}),
+    m_touched(target.getHeight(), false)
+{
+    assert(m_width <= UINT32_MAX / UINT8_MAX && "Rows are too wide for their channel sums to fit in 32 bits");
+    update(target, current);
+}
+
+void MomentTables::update(const geometrize::Bitmap& target, const geometrize::Bitmap& current)
+{
+    assert(target.getWidth() == m_width && current.getWidth() == m_width);
+    assert(target.getHeight() == m_height && current.getHeight() == m_height);
+
+    const std::size_t stride{m_width + 1U};
+    for(std::uint32_t y = 0; y < m_height; y++) {
+        updateRow(target, current, y, nullptr);
+
+        // Add up the rows of each whole band into its block sums
+        if((y + 1U) % blockRows == 0) {
+            const std::size_t block{y / blockRows};
+            for(std::size_t x = 0; x < stride; x++) {
+                geometrize::Moments& sum(m_blocks[block * stride + x]);
+                sum = geometrize::Moments{};
+                for(std::uint32_t row = y + 1U - blockRows; row <= y; row++) {
+                    add(sum, m_rows[row * stride + x], static_cast<std::int64_t>(x));
+                }
+            }
+        }
+    }
+}
+
+void MomentTables::updateRows(const geometrize::Bitmap& target, const geometrize::Bitmap& current, const std::vector<geometrize::Scanline>& lines)
+{
+    if(lines.empty()) {
+        return;
+    }
+
+    // Scanlines are usually sorted by row, but some shapes emit several scanlines for the same row
+    std::uint32_t firstRow{m_height};
+    std::uint32_t lastRow{0};
+    for(const geometrize::Scanline& line : lines) {
+        m_touched[line.y] = true;
+        firstRow = (std::min)(firstRow, static_cast<std::uint32_t>(line.y));
+        lastRow = (std::max)(lastRow, static_cast<std::uint32_t>(line.y));
+    }
+
+    // Update the touched rows, adding how much they changed by to the sums of the band they are in
+    const std::size_t stride{m_width + 1U};
+    const std::uint32_t blockCount{m_height / blockRows};
+    for(std::uint32_t y = firstRow; y <= lastRow; y++) {
+        if(m_touched[y]) {
+            const std::uint32_t block{y / blockRows};
+            updateRow(target, current, y, block < blockCount ? &m_blocks[block * stride] : nullptr);
+            m_touched[y] = false;
+        }
+    }
+}
+
+geometrize::Moments MomentTables::getMoments(const std::vector<geometrize::Scanline>& lines) const
+{
+    geometrize::Moments sum{};
+    for(const geometrize::Scanline& line : lines) {
+        addRowMoments(sum, line.y, line.x1, line.x2);
+    }
+    return sum;
+}
+
+geometrize::Moments MomentTables::getMoments(std::int32_t x1, std::int32_t y1, std::int32_t x2, std::int32_t y2) const
+{
+    geometrize::Moments sum{};
+
+    x1 = (std::max)(x1, 0);
+    y1 = (std::max)(y1, 0);
+    x2 = (std::min)(x2, static_cast<std::int32_t>(m_width) - 1);
+    y2 = (std::min)(y2, static_cast<std::int32_t>(m_height) - 1);
+    if(x1 > x2 || y1 > y2) {
+        return sum;
+    }
+
+    // Use the block sums for the whole bands of rows inside the rectangle, and the row sums for the remaining rows at the top and bottom
+    const std::uint32_t firstBlock{(static_cast<std::uint32_t>(y1) + blockRows - 1U) / blockRows};
+    const std::uint32_t lastBlock{(static_cast<std::uint32_t>(y2) + 1U) / blockRows};
+    if(firstBlock >= lastBlock) {
+        for(std::int32_t y = y1; y <= y2; y++) {
+            addRowMoments(sum, y, x1, x2);
+        }
+        return sum;
+    }
+
+    const std::size_t stride{m_width + 1U};
+    for(std::uint32_t block = firstBlock; block < lastBlock; block++) {
+        addDifference(sum, m_blocks[block * stride + x2 + 1U], m_blocks[block * stride + x1]);
+    }
+    for(std::uint32_t y = static_cast<std::uint32_t>(y1); y < firstBlock * blockRows; y++) {
+        addRowMoments(sum, y, x1, x2);
+    }
+    for(std::uint32_t y = lastBlock * blockRows; y <= static_cast<std::uint32_t>(y2); y++) {
+        addRowMoments(sum, y, x1, x2);
+    }
+    return sum;
+}
+
+std::uint32_t MomentTables::getWidth() const
+{
+    return m_width;
+}
+
+std::uint32_t MomentTables::getHeight() const
+{
+    return m_height;
+}
+
+void MomentTables::updateRow(const geometrize::Bitmap& target, const geometrize::Bitmap& current, const std::uint32_t y, geometrize::Moments* block)
+{
+    geometrize::RowMoments* row{&m_rows[static_cast<std::size_t>(y) * (m_width + 1U)]};
+    geometrize::RowMoments sum{};
+    row[0] = sum;
+    for(std::uint32_t x = 0; x < m_width; x++) {
+        const geometrize::rgba t(target.getPixel(x, y));
+        const geometrize::rgba c(current.getPixel(x, y));
+
+        sum.target[0] += t.r;
+        sum.target[1] += t.g;
+        sum.target[2] += t.b;
+        sum.target[3] += t.a;
+        sum.current[0] += c.r;
+        sum.current[1] += c.g;
+        sum.current[2] += c.b;
+        sum.current[3] += c.a;
+        sum.targetCurrent += t.r * c.r + t.g * c.g + t.b * c.b + t.a * c.a;
+        sum.currentSquared += c.r * c.r + c.g * c.g + c.b * c.b + c.a * c.a;
+
+        // Add how much the row changed by to the sums of the band it is in
+        if(block) {
+            addDifference(block[x + 1U], sum, row[x + 1U], 0);
+        }
+        row[x + 1U] = sum;
+    }
+}
+
+void MomentTables::addRowMoments(geometrize::Moments& sum, const std::uint32_t y, const std::int32_t x1, const std::int32_t x2) const
+{
+    const geometrize::RowMoments* row{&m_rows[static_cast<std::size_t>(y) * (m_width + 1U)]};
+    addDifference(sum, row[x2 + 1], row[x1], x2 - x1 + 1);
+}
+
+}
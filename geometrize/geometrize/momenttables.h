@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace geometrize
+{
+class Bitmap;
+class Scanline;
+}
+
+namespace geometrize
+{
+
+/**
+ * @brief The Moments struct holds the sums of the target and current pixel values (and their products) over a set of pixels.
+ * These are enough to calculate the best color and the change in error of blending a constant color over those pixels.
+ * @author Sam Twidale (http://samcodes.co.uk/)
+ */
+struct Moments
+{
+    std::int64_t target[4]; ///< Sum of the target pixel values, per RGBA channel.
+    std::int64_t current[4]; ///< Sum of the current pixel values, per RGBA channel.
+    std::int64_t targetCurrent; ///< Sum of target * current, over all channels.
+    std::int64_t currentSquared; ///< Sum of current * current, over all channels.
+    std::int64_t count; ///< The number of pixels summed.
+};
+
+/**
+ * @brief The RowMoments struct holds the moments of the pixels from the start of a row, as stored in the row prefix sums of the moment tables.
+ * The channel sums of a row fit in 32 bits for rows of up to UINT32_MAX / 255 pixels, only the products need 64 bits. The number of pixels summed is the position in the row, so it is not stored.
+ * @author Sam Twidale (http://samcodes.co.uk/)
+ */
+struct RowMoments
+{
+    std::int64_t targetCurrent; ///< Sum of target * current, over all channels.
+    std::int64_t currentSquared; ///< Sum of current * current, over all channels.
+    std::uint32_t target[4]; ///< Sum of the target pixel values, per RGBA channel.
+    std::uint32_t current[4]; ///< Sum of the current pixel values, per RGBA channel.
+};
+
+/**
+ * @brief The MomentTables class keeps row-wise prefix sums of the target and current bitmap moments.
+ * This lets the moments of any scanline be looked up in constant time, instead of visiting every pixel on it.
+ * The row sums are also added up over each band of a few rows, so the moments of an axis-aligned rectangle can be looked up a band at a time instead of a row at a time,
+ * and drawing a shape only changes the sums of the bands it covers.
+ * @author Sam Twidale (http://samcodes.co.uk/)
+ */
+class MomentTables
+{
+public:
+    /**
+     * @brief MomentTables Creates moment tables for the given target and current bitmaps.
+     * The target bitmap and current bitmap must be the same size (width and height).
+     * @param target The target bitmap.
+     * @param current The current bitmap.
+     */
+    MomentTables(const geometrize::Bitmap& target, const geometrize::Bitmap& current);
+    ~MomentTables() = default;
+    MomentTables& operator=(const MomentTables&) = delete;
+    MomentTables(const MomentTables&) = delete;
+
+    /**
+     * @brief update Recalculates the tables for every row of the bitmaps.
+     * @param target The target bitmap.
+     * @param current The current bitmap.
+     */
+    void update(const geometrize::Bitmap& target, const geometrize::Bitmap& current);
+
+    /**
+     * @brief updateRows Recalculates the tables for the rows covered by the given scanlines, use after drawing them to the current bitmap.
+     * The sums of the bands holding those rows are adjusted by the change in those rows, so this takes time proportional to the width times the number of rows covered.
+     * @param target The target bitmap.
+     * @param current The current bitmap.
+     * @param lines The scanlines that were drawn.
+     */
+    void updateRows(const geometrize::Bitmap& target, const geometrize::Bitmap& current, const std::vector<geometrize::Scanline>& lines);
+
+    /**
+     * @brief getMoments Sums the moments of the pixels covered by the scanlines.
+     * @param lines The scanlines.
+     * @return The moments of the pixels covered by the scanlines.
+     */
+    geometrize::Moments getMoments(const std::vector<geometrize::Scanline>& lines) const;
+
+    /**
+     * @brief getMoments Sums the moments of the pixels in an axis-aligned rectangle. The rectangle is clipped to the bitmap bounds.
+     * @param x1 The leftmost x-coordinate of the rectangle (inclusive).
+     * @param y1 The topmost y-coordinate of the rectangle (inclusive).
+     * @param x2 The rightmost x-coordinate of the rectangle (inclusive).
+     * @param y2 The bottommost y-coordinate of the rectangle (inclusive).
+     * @return The moments of the pixels in the rectangle.
+     */
+    geometrize::Moments getMoments(std::int32_t x1, std::int32_t y1, std::int32_t x2, std::int32_t y2) const;
+
+    /**
+     * @brief getWidth Gets the width of the bitmaps the tables were made for.
+     * @return The width of the bitmaps.
+     */
+    std::uint32_t getWidth() const;
+
+    /**
+     * @brief getHeight Gets the height of the bitmaps the tables were made for.
+     * @return The height of the bitmaps.
+     */
+    std::uint32_t getHeight() const;
+
+private:
+    void updateRow(const geometrize::Bitmap& target, const geometrize::Bitmap& current, std::uint32_t y, geometrize::Moments* block);
+    void addRowMoments(geometrize::Moments& sum, std::uint32_t y, std::int32_t x1, std::int32_t x2) const;
+
+    static const std::uint32_t blockRows{16}; ///< The number of rows in each band of the block sum table.
+
+    std::uint32_t m_width; ///< The width of the bitmaps.
+    std::uint32_t m_height; ///< The height of the bitmaps.
+    std::vector<geometrize::RowMoments> m_rows; ///< The prefix sums, (width + 1) entries per row, the first entry of each row is zero.
+    std::vector<geometrize::Moments> m_blocks; ///< The row prefix sums summed over each whole band of blockRows rows, (width + 1) entries per band. Rows below the last whole band are not included.
+    std::vector<bool> m_touched; ///< Which rows updateRows has to recalculate, kept between calls so it does not allocate. Cleared after each update.
+};
+
+}
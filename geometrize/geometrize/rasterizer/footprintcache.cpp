@@ -0,0 +1,137 @@
+#include "footprintcache.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "scanline.h"
+#include "../shape/shapetypes.h"
+
+namespace
+{
+
+const std::size_t entryCount{1024}; ///< The number of slots in each thread's cache, must be a power of two.
+
+std::size_t getSlot(const geometrize::ShapeTypes type, const std::int32_t (&parameters)[geometrize::FootprintCache::maxParameters])
+{
+    std::uint32_t hash{static_cast<std::uint32_t>(type) * 0x9E3779B1U};
+    for(std::size_t i = 0; i < geometrize::FootprintCache::maxParameters; i++) {
+        hash = (hash ^ static_cast<std::uint32_t>(parameters[i])) * 0x85EBCA6BU;
+        hash ^= hash >> 13;
+    }
+    return hash & (entryCount - 1U);
+}
+
+}
+
+namespace geometrize
+{
+
+/**
+ * @brief The FootprintCache::Entry struct is a slot in a footprint cache.
+ */
+struct FootprintCache::Entry
+{
+    Entry() : type{geometrize::ShapeTypes::SHAPE_COUNT}, parameters{0, 0, 0} {}
+
+    geometrize::ShapeTypes type; ///< The type of shape the footprint is for, or SHAPE_COUNT if the slot is empty.
+    std::int32_t parameters[maxParameters]; ///< The parameters the footprint was built with.
+    Footprint footprint; ///< The footprint.
+};
+
+void FootprintCache::Footprint::updateBounds()
+{
+    minX = 0;
+    maxX = -1;
+    minY = 0;
+    maxY = -1;
+    if(lines.empty()) {
+        return;
+    }
+    minX = maxX = lines[0U].x1;
+    minY = maxY = lines[0U].y;
+    for(const geometrize::Scanline& line : lines) {
+        minX = (std::min)(minX, line.x1);
+        maxX = (std::max)(maxX, line.x2);
+        minY = (std::min)(minY, line.y);
+        maxY = (std::max)(maxY, line.y);
+    }
+}
+
+FootprintCache::Entry& FootprintCache::getEntry(const geometrize::ShapeTypes type, const std::int32_t (&parameters)[maxParameters])
+{
+    thread_local static Entry entries[entryCount];
+    return entries[getSlot(type, parameters)];
+}
+
+FootprintCache::Footprint* FootprintCache::find(const geometrize::ShapeTypes type, const std::int32_t (&parameters)[maxParameters])
+{
+    Entry& entry(getEntry(type, parameters));
+    if(entry.type != type) {
+        return nullptr;
+    }
+    for(std::size_t i = 0; i < maxParameters; i++) {
+        if(entry.parameters[i] != parameters[i]) {
+            return nullptr;
+        }
+    }
+    return &entry.footprint;
+}
+
+FootprintCache::Footprint& FootprintCache::insert(const geometrize::ShapeTypes type, const std::int32_t (&parameters)[maxParameters])
+{
+    Entry& entry(getEntry(type, parameters));
+    entry.type = type;
+    for(std::size_t i = 0; i < maxParameters; i++) {
+        entry.parameters[i] = parameters[i];
+    }
+    entry.footprint.lines.clear();
+    return entry.footprint;
+}
+
+void FootprintCache::translate(const Footprint& footprint, const std::int32_t x, const std::int32_t y, const std::int32_t w, const std::int32_t h, std::vector<geometrize::Scanline>& lines)
+{
+    lines.clear();
+    if(footprint.minX + x >= 0 && footprint.maxX + x < w && footprint.minY + y >= 0 && footprint.maxY + y < h) {
+        lines.resize(footprint.lines.size(), geometrize::Scanline(0, 0, 0));
+        for(std::size_t i = 0; i < footprint.lines.size(); i++) {
+            const geometrize::Scanline& line(footprint.lines[i]);
+            lines[i] = geometrize::Scanline(line.y + y, line.x1 + x, line.x2 + x);
+        }
+        return;
+    }
+
+    for(const geometrize::Scanline& line : footprint.lines) {
+        const std::int32_t ly{line.y + y};
+        if(ly < 0 || ly >= h) {
+            continue;
+        }
+        const std::int32_t x1{line.x1 + x};
+        const std::int32_t x2{line.x2 + x};
+        if(x1 >= w || x2 < 0) {
+            continue;
+        }
+        lines.push_back(geometrize::Scanline(ly, x1 < 0 ? 0 : x1, x2 >= w ? w - 1 : x2));
+    }
+}
+
+void FootprintCache::translateInPlace(const std::int32_t x, const std::int32_t y, const std::int32_t w, const std::int32_t h, std::vector<geometrize::Scanline>& lines)
+{
+    std::size_t kept{0};
+    for(const geometrize::Scanline& line : lines) {
+        const std::int32_t ly{line.y + y};
+        if(ly < 0 || ly >= h) {
+            continue;
+        }
+        const std::int32_t x1{line.x1 + x};
+        const std::int32_t x2{line.x2 + x};
+        if(x1 >= w || x2 < 0) {
+            continue;
+        }
+        lines[kept++] = geometrize::Scanline(ly, x1 < 0 ? 0 : x1, x2 >= w ? w - 1 : x2);
+    }
+    lines.resize(kept, geometrize::Scanline(0, 0, 0));
+}
+
+}
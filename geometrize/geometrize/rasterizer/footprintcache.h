@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "scanline.h"
+#include "../shape/shapetypes.h"
+
+namespace geometrize
+{
+
+/**
+ * @brief The FootprintCache class caches the scanlines of shapes relative to their position, for shapes whose scanlines only depend on a few parameters such as their size and angle.
+ * Translating a cached footprint takes time proportional to its number of scanlines, so this helps shapes that take longer than that to rasterize (such as circles) when hill climbing moves them around without resizing them.
+ * Each thread has its own direct-mapped cache, so no locking is needed. A footprint is simply built again when its slot was taken by another footprint, so the scanlines are the same whether or not the cache hits.
+ * Footprints of more than maxCachedLines scanlines are never cached, they are built and translated in place every time, so each thread's cache stays small however large the shapes grow.
+ * @author Sam Twidale (http://samcodes.co.uk/)
+ */
+class FootprintCache
+{
+public:
+    static const std::size_t maxParameters{3}; ///< The maximum number of parameters a footprint can depend on.
+    static const std::size_t maxCachedLines{512}; ///< The maximum number of scanlines in a cached footprint, which bounds each thread's cache at about 6 MB.
+
+    /**
+     * @brief rasterize Gets the scanlines of a shape by translating its footprint and cropping it to the bitmap, building the footprint first if it is not in the cache.
+     * @param type The type of shape.
+     * @param parameters The parameters that the footprint depends on. Unused parameters should be 0.
+     * @param x The x-coordinate to translate the footprint to.
+     * @param y The y-coordinate to translate the footprint to.
+     * @param w The width of the bitmap to crop to.
+     * @param h The height of the bitmap to crop to.
+     * @param lines The vector to put the scanlines in, its contents are replaced.
+     * @param build A function that takes a std::vector<geometrize::Scanline>& and fills it with the uncropped scanlines of the shape positioned at the origin.
+     */
+    template<typename F>
+    static void rasterize(
+            const geometrize::ShapeTypes type,
+            const std::int32_t (&parameters)[maxParameters],
+            const std::int32_t x,
+            const std::int32_t y,
+            const std::int32_t w,
+            const std::int32_t h,
+            std::vector<geometrize::Scanline>& lines,
+            F&& build)
+    {
+        const Footprint* footprint{find(type, parameters)};
+        if(footprint != nullptr) {
+            translate(*footprint, x, y, w, h, lines);
+            return;
+        }
+
+        lines.clear();
+        build(lines);
+        if(lines.size() > maxCachedLines) {
+            translateInPlace(x, y, w, h, lines);
+            return;
+        }
+        Footprint& inserted(insert(type, parameters));
+        inserted.lines.assign(lines.begin(), lines.end());
+        inserted.updateBounds();
+        translate(inserted, x, y, w, h, lines);
+    }
+
+private:
+    /**
+     * @brief The Footprint struct holds the scanlines of a shape positioned at the origin, and their bounds.
+     */
+    struct Footprint
+    {
+        /**
+         * @brief updateBounds Recalculates the bounds of the scanlines.
+         */
+        void updateBounds();
+
+        std::vector<geometrize::Scanline> lines; ///< The scanlines of the shape positioned at the origin.
+        std::int32_t minX; ///< The leftmost x-coordinate of the scanlines.
+        std::int32_t maxX; ///< The rightmost x-coordinate of the scanlines.
+        std::int32_t minY; ///< The lowest y-coordinate of the scanlines.
+        std::int32_t maxY; ///< The highest y-coordinate of the scanlines.
+    };
+
+    struct Entry;
+
+    /**
+     * @brief getEntry Gets the slot in the calling thread's cache that a footprint belongs in.
+     * @return The slot.
+     */
+    static Entry& getEntry(geometrize::ShapeTypes type, const std::int32_t (&parameters)[maxParameters]);
+
+    /**
+     * @brief find Finds a footprint in the calling thread's cache.
+     * @return The footprint, or nullptr if it is not in the cache.
+     */
+    static Footprint* find(geometrize::ShapeTypes type, const std::int32_t (&parameters)[maxParameters]);
+
+    /**
+     * @brief insert Claims the slot for a footprint in the calling thread's cache, evicting whatever footprint was there.
+     * @return The footprint to fill in, with no scanlines.
+     */
+    static Footprint& insert(geometrize::ShapeTypes type, const std::int32_t (&parameters)[maxParameters]);
+
+    /**
+     * @brief translate Translates a footprint and crops it to the bitmap, skipping the cropping when the whole footprint lands inside the bitmap.
+     */
+    static void translate(const Footprint& footprint, std::int32_t x, std::int32_t y, std::int32_t w, std::int32_t h, std::vector<geometrize::Scanline>& lines);
+
+    /**
+     * @brief translateInPlace Translates the scanlines of a footprint that is not cached and crops them to the bitmap, in place.
+     */
+    static void translateInPlace(std::int32_t x, std::int32_t y, std::int32_t w, std::int32_t h, std::vector<geometrize::Scanline>& lines);
+};
+
+}
@@ -1,15 +1,17 @@
 #include "rasterizer.h"
 
 #include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <cstdlib>
-#include <map>
-#include <set>
+#include <cstring>
 #include <utility>
 #include <vector>
 
 #include "../bitmap/bitmap.h"
+#include "../bitmap/pixelformat.h"
 #include "../bitmap/rgba.h"
+#include "../spankernels.h"
 #include "scanline.h"
 
 namespace geometrize
@@ -17,121 +19,95 @@ namespace geometrize
 
 void drawLines(geometrize::Bitmap& image, const geometrize::rgba color, const std::vector<geometrize::Scanline>& lines)
 {
-    // Convert the non-premultiplied color to alpha-premultiplied 16-bits per channel RGBA
-    // In other words, scale the rgb color components by the alpha component
-    std::uint32_t sr{color.r};
-    sr |= sr << 8;
-    sr *= color.a;
-    sr /= UINT8_MAX;
-    std::uint32_t sg{color.g};
-    sg |= sg << 8;
-    sg *= color.a;
-    sg /= UINT8_MAX;
-    std::uint32_t sb{color.b};
-    sb |= sb << 8;
-    sb *= color.a;
-    sb /= UINT8_MAX;
-    std::uint32_t sa{color.a};
-    sa |= sa << 8;
+    drawLines(image, color, lines, false);
+}
 
-    const std::uint32_t m{UINT16_MAX};
-    const std::uint32_t aa{(m - sa) * 257U};
+void drawLines(geometrize::Bitmap& image, const geometrize::rgba color, const std::vector<geometrize::Scanline>& lines, const bool opaque)
+{
+    // Blend the alpha-premultiplied 16-bits per channel color with each run of pixels
+    // This is exact integer arithmetic, scaling the rgb color components by the alpha component and blending with the image as 16-bit values
+    // GRAY8 images are blended with the luminance of the color, which for a gray color is the same as blending each channel of the opaque RGBA pixels
+    std::uint8_t* data{image.getDataRef().data()};
+    const std::size_t width{image.getWidth()};
+    if(image.getFormat() == geometrize::PixelFormat::GRAY8) {
+        const geometrize::kernels::BlendConstants blend(geometrize::kernels::grayBlendConstants(geometrize::luminance(color), color.a));
+        for(const geometrize::Scanline& line : lines) {
+            const std::size_t offset{static_cast<std::size_t>(line.y) * width + static_cast<std::size_t>(line.x1)};
+            geometrize::kernels::blendGray(data + offset, static_cast<std::size_t>(line.x2 - line.x1 + 1), blend);
+        }
+        return;
+    }
 
+    const geometrize::kernels::BlendConstants blend(geometrize::kernels::blendConstants(color.r, color.g, color.b, color.a, opaque));
     for(const geometrize::Scanline& line : lines) {
-        const std::int32_t y{line.y};
-
-        for(std::int32_t x = line.x1; x <= line.x2; x++) {
-            const geometrize::rgba d(image.getPixel(x, y));
-
-            const std::uint8_t r{static_cast<std::uint8_t>(((d.r * aa + sr * m) / m) >> 8)};
-            const std::uint8_t g{static_cast<std::uint8_t>(((d.g * aa + sg * m) / m) >> 8)};
-            const std::uint8_t b{static_cast<std::uint8_t>(((d.b * aa + sb * m) / m) >> 8)};
-            const std::uint8_t a{static_cast<std::uint8_t>(((d.a * aa + sa * m) / m) >> 8)};
-
-            image.setPixel(x, y, geometrize::rgba{r, g, b, a});
-        }
+        const std::size_t offset{(static_cast<std::size_t>(line.y) * width + static_cast<std::size_t>(line.x1)) * 4U};
+        geometrize::kernels::blend(data + offset, static_cast<std::size_t>(line.x2 - line.x1 + 1), blend);
     }
 }
 
 void copyLines(geometrize::Bitmap& destination, const geometrize::Bitmap& source, const std::vector<geometrize::Scanline>& lines)
 {
+    std::uint8_t* destinationData{destination.getDataRef().data()};
+    const std::uint8_t* sourceData{source.getDataRef().data()};
+    const std::size_t width{destination.getWidth()};
+    const std::size_t bytesPerPixel{geometrize::getBytesPerPixel(destination.getFormat())};
     for(const geometrize::Scanline& line : lines) {
-        const std::int32_t y{line.y};
-        for(std::int32_t x = line.x1; x < line.x2; x++) {
-            destination.setPixel(x, y, source.getPixel(x, y));
-        }
+        const std::size_t offset{(static_cast<std::size_t>(line.y) * width + static_cast<std::size_t>(line.x1)) * bytesPerPixel};
+        std::memcpy(destinationData + offset, sourceData + offset, static_cast<std::size_t>(line.x2 - line.x1 + 1) * bytesPerPixel);
     }
 }
 
-std::vector<std::pair<std::int32_t, std::int32_t>> bresenham(std::int32_t x1, std::int32_t y1, const std::int32_t x2, const std::int32_t y2)
+std::vector<std::pair<std::int32_t, std::int32_t>> bresenham(const std::int32_t x1, const std::int32_t y1, const std::int32_t x2, const std::int32_t y2)
 {
-    std::int32_t dx{x2 - x1};
-    const std::int8_t ix{static_cast<std::int8_t>((dx > 0) - (dx < 0))};
-    dx = std::abs(dx) << 1;
-
-    std::int32_t dy{y2 - y1};
-    const std::int8_t iy{static_cast<std::int8_t>((dy > 0) - (dy < 0))};
-    dy = std::abs(dy) << 1;
-
     std::vector<std::pair<std::int32_t, std::int32_t>> points;
-    points.push_back(std::make_pair(x1, y1));
-
-    if (dx >= dy) {
-        std::int32_t error(dy - (dx >> 1));
-        while (x1 != x2) {
-            if (error >= 0 && (error || (ix > 0))) {
-                error -= dx;
-                y1 += iy;
-            }
-
-            error += dy;
-            x1 += ix;
-
-            points.push_back(std::make_pair(x1, y1));
-        }
-    } else {
-        std::int32_t error(dx - (dy >> 1));
-        while (y1 != y2) {
-            if (error >= 0 && (error || (iy > 0))) {
-                error -= dy;
-                x1 += ix;
-            }
-
-            error += dx;
-            y1 += iy;
-
-            points.push_back(std::make_pair(x1, y1));
-        }
-    }
-
+    geometrize::bresenham(x1, y1, x2, y2, [&points](const std::int32_t x, const std::int32_t y) {
+        points.push_back(std::make_pair(x, y));
+    });
     return points;
 }
 
 std::vector<geometrize::Scanline> scanlinesForPolygon(const std::vector<std::pair<std::int32_t, std::int32_t>>& points)
 {
     std::vector<geometrize::Scanline> lines;
+    geometrize::scanlinesForPolygon(points.data(), points.size(), lines);
+    return lines;
+}
 
-    std::vector<std::pair<std::int32_t, std::int32_t>> edges;
-    for(std::size_t i = 0; i < points.size(); i++) {
-        const std::pair<std::int32_t, std::int32_t> p1{points[i]};
-        const std::pair<std::int32_t, std::int32_t> p2{(i == (points.size() - 1)) ? points[0U] : points[i + 1U]};
-        const std::vector<std::pair<std::int32_t, std::int32_t>> p1p2{geometrize::bresenham(p1.first, p1.second, p2.first, p2.second)};
-        edges.insert(edges.end(), p1p2.begin(), p1p2.end());
+void scanlinesForPolygon(const std::pair<std::int32_t, std::int32_t>* const points, const std::size_t pointCount, std::vector<geometrize::Scanline>& lines)
+{
+    lines.clear();
+    if(pointCount == 0) {
+        return;
     }
 
-    std::map<std::int32_t, std::set<std::int32_t>> yToXs;
-    for(std::pair<std::int32_t, std::int32_t> point : edges) {
-        yToXs[point.second].insert(point.first);
+    // Every point on the edges lies between the topmost and bottommost vertices
+    std::int32_t minY{points[0U].second};
+    std::int32_t maxY{points[0U].second};
+    for(std::size_t i = 0; i < pointCount; i++) {
+        minY = (std::min)(minY, points[i].second);
+        maxY = (std::max)(maxY, points[i].second);
     }
 
-    for(const auto& it : yToXs) {
-        const geometrize::Scanline scanline(it.first,
-        *(std::min_element(it.second.begin(), it.second.end())),
-        *(std::max_element(it.second.begin(), it.second.end())));
-        lines.push_back(scanline);
+    // Track the leftmost and rightmost edge point on each row, in a flat table that is reused between calls
+    thread_local static std::vector<std::pair<std::int32_t, std::int32_t>> extents;
+    extents.assign(static_cast<std::size_t>(maxY - minY) + 1U, std::make_pair(INT32_MAX, INT32_MIN));
+
+    for(std::size_t i = 0; i < pointCount; i++) {
+        const std::pair<std::int32_t, std::int32_t> p1{points[i]};
+        const std::pair<std::int32_t, std::int32_t> p2{(i == (pointCount - 1)) ? points[0U] : points[i + 1U]};
+        geometrize::bresenham(p1.first, p1.second, p2.first, p2.second, [minY](const std::int32_t x, const std::int32_t y) {
+            std::pair<std::int32_t, std::int32_t>& extent(extents[static_cast<std::size_t>(y - minY)]);
+            extent.first = (std::min)(extent.first, x);
+            extent.second = (std::max)(extent.second, x);
+        });
     }
 
-    return lines;
+    lines.reserve(extents.size());
+    for(std::size_t i = 0; i < extents.size(); i++) {
+        if(extents[i].first <= extents[i].second) {
+            lines.push_back(geometrize::Scanline(minY + static_cast<std::int32_t>(i), extents[i].first, extents[i].second));
+        }
+    }
 }
 
 }
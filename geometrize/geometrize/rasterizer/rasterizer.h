@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include <cstdlib>
 #include <utility>
 #include <vector>
 
@@ -23,6 +25,15 @@ namespace geometrize
  */
 void drawLines(geometrize::Bitmap& image, geometrize::rgba color, const std::vector<geometrize::Scanline>& lines);
 
+/**
+ * @brief drawLines Draws scanlines onto an image.
+ * @param image The image to be drawn to.
+ * @param color The color of the scanlines.
+ * @param lines The scanlines to draw.
+ * @param opaque Whether every pixel of the image is opaque, which lets the scalar span kernels skip the alpha channel.
+ */
+void drawLines(geometrize::Bitmap& image, geometrize::rgba color, const std::vector<geometrize::Scanline>& lines, bool opaque);
+
 /**
  * @brief copyLines Copies source pixels to a destination defined by a set of scanlines.
  * @param destination The destination bitmap to copy the lines to.
@@ -31,6 +42,56 @@ void drawLines(geometrize::Bitmap& image, geometrize::rgba color, const std::vec
  */
 void copyLines(geometrize::Bitmap& destination, const geometrize::Bitmap& source, const std::vector<geometrize::Scanline>& lines);
 
+/**
+ * @brief bresenham Bresenham's line algorithm. Calls a function for each point on the line, in order from the start to the end, without allocating.
+ * @param x1 The start x-coordinate.
+ * @param y1 The start y-coordinate.
+ * @param x2 The end x-coordinate.
+ * @param y2 The end y-coordinate.
+ * @param visit The function to call for each point, with signature void(std::int32_t x, std::int32_t y).
+ */
+template<typename F>
+void bresenham(std::int32_t x1, std::int32_t y1, const std::int32_t x2, const std::int32_t y2, F&& visit)
+{
+    std::int32_t dx{x2 - x1};
+    const std::int8_t ix{static_cast<std::int8_t>((dx > 0) - (dx < 0))};
+    dx = std::abs(dx) << 1;
+
+    std::int32_t dy{y2 - y1};
+    const std::int8_t iy{static_cast<std::int8_t>((dy > 0) - (dy < 0))};
+    dy = std::abs(dy) << 1;
+
+    visit(x1, y1);
+
+    if (dx >= dy) {
+        std::int32_t error(dy - (dx >> 1));
+        while (x1 != x2) {
+            if (error >= 0 && (error || (ix > 0))) {
+                error -= dx;
+                y1 += iy;
+            }
+
+            error += dy;
+            x1 += ix;
+
+            visit(x1, y1);
+        }
+    } else {
+        std::int32_t error(dx - (dy >> 1));
+        while (y1 != y2) {
+            if (error >= 0 && (error || (iy > 0))) {
+                error -= dy;
+                x1 += ix;
+            }
+
+            error += dx;
+            y1 += iy;
+
+            visit(x1, y1);
+        }
+    }
+}
+
 /**
  * @brief bresenham Bresenham's line algorithm. Returns the points on the line.
  * @param x1 The start x-coordinate.
@@ -48,4 +109,13 @@ std::vector<std::pair<std::int32_t, std::int32_t>> bresenham(std::int32_t x1, st
  */
 std::vector<geometrize::Scanline> scanlinesForPolygon(const std::vector<std::pair<std::int32_t, std::int32_t>>& points);
 
+/**
+ * @brief scanlinesForPolygon Gets the scanlines for a series of points that make up an arbitrary polygon, replacing the contents of the given vector.
+ * Reusing the same vector between calls avoids allocating once it has grown large enough.
+ * @param points The vertices of the polygon.
+ * @param pointCount The number of vertices.
+ * @param lines The vector to write the scanlines for the polygon to.
+ */
+void scanlinesForPolygon(const std::pair<std::int32_t, std::int32_t>* points, std::size_t pointCount, std::vector<geometrize::Scanline>& lines);
+
 }
@@ -1,5 +1,7 @@
 #include "scanline.h"
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <vector>
 
@@ -12,9 +14,16 @@ Scanline::Scanline(const std::int32_t y, const std::int32_t x1, const std::int32
 
 std::vector<geometrize::Scanline> Scanline::trim(std::vector<geometrize::Scanline>& scanlines, const std::uint32_t w, const std::uint32_t h)
 {
-    std::vector<geometrize::Scanline> trimmedScanlines;
+    std::vector<geometrize::Scanline> trimmedScanlines(scanlines);
+    trimInPlace(trimmedScanlines, w, h);
+    return trimmedScanlines;
+}
 
-    for(geometrize::Scanline& line : scanlines) {
+void Scanline::trimInPlace(std::vector<geometrize::Scanline>& scanlines, const std::uint32_t w, const std::uint32_t h)
+{
+    std::size_t count{0};
+    for(std::size_t i = 0; i < scanlines.size(); i++) {
+        geometrize::Scanline line(scanlines[i]);
         if(line.y < 0 || line.y >= static_cast<std::int32_t>(h) || line.x1 >= static_cast<std::int32_t>(w) || line.x2 < 0) {
             continue;
         }
@@ -23,10 +32,77 @@ std::vector<geometrize::Scanline> Scanline::trim(std::vector<geometrize::Scanlin
         if(line.x1 > line.x2) {
             continue;
         }
-        trimmedScanlines.push_back(line);
+        scanlines[count++] = line;
     }
+    scanlines.erase(scanlines.begin() + static_cast<std::ptrdiff_t>(count), scanlines.end());
+}
 
-    return trimmedScanlines;
+void Scanline::coalesce(std::vector<geometrize::Scanline>& scanlines)
+{
+    if(scanlines.size() < 2U) {
+        return;
+    }
+
+    // Skip the sort when the scanlines are already in order (or in reverse order) and do not overlap or touch, which is common for strokes
+    std::int32_t minY{scanlines[0U].y};
+    std::int32_t maxY{scanlines[0U].y};
+    bool ascending{true};
+    bool descending{true};
+    for(std::size_t i = 1; i < scanlines.size(); i++) {
+        const geometrize::Scanline& previous(scanlines[i - 1U]);
+        const geometrize::Scanline& line(scanlines[i]);
+        ascending = ascending && (previous.y < line.y || (previous.y == line.y && previous.x2 + 1 < line.x1));
+        descending = descending && (previous.y > line.y || (previous.y == line.y && line.x2 + 1 < previous.x1));
+        minY = (std::min)(minY, line.y);
+        maxY = (std::max)(maxY, line.y);
+    }
+    if(ascending) {
+        return;
+    }
+    if(descending) {
+        std::reverse(scanlines.begin(), scanlines.end());
+        return;
+    }
+
+    // Counting sort the scanlines by row, keeping their order within each row, using buffers that are reused between calls
+    thread_local static std::vector<std::size_t> offsets;
+    thread_local static std::vector<geometrize::Scanline> sorted;
+    offsets.assign(static_cast<std::size_t>(maxY - minY) + 2U, 0U);
+    for(const geometrize::Scanline& line : scanlines) {
+        offsets[static_cast<std::size_t>(line.y - minY) + 1U]++;
+    }
+    for(std::size_t i = 1; i < offsets.size(); i++) {
+        offsets[i] += offsets[i - 1U];
+    }
+    sorted.assign(scanlines.begin(), scanlines.end());
+    for(const geometrize::Scanline& line : scanlines) {
+        sorted[offsets[static_cast<std::size_t>(line.y - minY)]++] = line;
+    }
+
+    // Each row now ends where the next one starts, rows usually have very few scanlines so sort them by insertion and merge them
+    std::size_t count{0};
+    std::size_t rowStart{0};
+    for(std::size_t row = 0; row + 1U < offsets.size(); row++) {
+        const std::size_t rowEnd{offsets[row]};
+        for(std::size_t i = rowStart + 1U; i < rowEnd; i++) {
+            const geometrize::Scanline line(sorted[i]);
+            std::size_t j{i};
+            for(; j > rowStart && sorted[j - 1U].x1 > line.x1; j--) {
+                sorted[j] = sorted[j - 1U];
+            }
+            sorted[j] = line;
+        }
+        for(std::size_t i = rowStart; i < rowEnd; i++) {
+            const geometrize::Scanline& line(sorted[i]);
+            if(i > rowStart && line.x1 <= scanlines[count - 1U].x2 + 1) {
+                scanlines[count - 1U].x2 = (std::max)(scanlines[count - 1U].x2, line.x2);
+            } else {
+                scanlines[count++] = line;
+            }
+        }
+        rowStart = rowEnd;
+    }
+    scanlines.erase(scanlines.begin() + static_cast<std::ptrdiff_t>(count), scanlines.end());
 }
 
 bool operator==(const geometrize::Scanline& lhs, const geometrize::Scanline& rhs)
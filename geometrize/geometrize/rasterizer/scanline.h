@@ -34,7 +34,43 @@ public:
      */
     static std::vector<geometrize::Scanline> trim(std::vector<geometrize::Scanline>& scanlines, std::uint32_t w, std::uint32_t h);
 
-    const std::int32_t y; ///< The y-coordinate of the scanline.
+    /**
+     * @brief trimInPlace Crops the scanning width of an array of scanlines so they do not scan outside of the given area, removing scanlines that are entirely outside of it.
+     * Unlike trim this modifies the given vector rather than allocating a new one. The order of the remaining scanlines is kept.
+     * @param scanlines The scanlines to crop.
+     * @param w The width to crop.
+     * @param h The height to crop.
+     */
+    static void trimInPlace(std::vector<geometrize::Scanline>& scanlines, std::uint32_t w, std::uint32_t h);
+
+    /**
+     * @brief coalesce Sorts an array of scanlines by row and merges scanlines on the same row that overlap or touch, so every pixel is covered exactly once.
+     * Shapes that are drawn a pixel at a time (such as lines) produce many single pixel scanlines, some of them duplicates, so this makes them cheaper to draw and score.
+     * @param scanlines The scanlines to coalesce.
+     */
+    static void coalesce(std::vector<geometrize::Scanline>& scanlines);
+
+    /**
+     * @brief addPixel Adds a single pixel to an array of scanlines, extending the last scanline instead when the pixel is on the same row and touches it.
+     * This merges runs of pixels and repeated pixels as shapes that are drawn a pixel at a time are rasterized, leaving less for coalesce to do.
+     * @param scanlines The scanlines to add the pixel to.
+     * @param x The x-coordinate of the pixel.
+     * @param y The y-coordinate of the pixel.
+     */
+    static void addPixel(std::vector<geometrize::Scanline>& scanlines, const std::int32_t x, const std::int32_t y)
+    {
+        if(!scanlines.empty()) {
+            geometrize::Scanline& last(scanlines.back());
+            if(last.y == y && x >= last.x1 - 1 && x <= last.x2 + 1) {
+                last.x1 = x < last.x1 ? x : last.x1;
+                last.x2 = x > last.x2 ? x : last.x2;
+                return;
+            }
+        }
+        scanlines.push_back(geometrize::Scanline(y, x, x));
+    }
+
+    std::int32_t y; ///< The y-coordinate of the scanline.
     std::int32_t x1; ///< The leftmost x-coordinate of the scanline.
     std::int32_t x2; ///< The rightmost x-coordinate of the scanline.
 };
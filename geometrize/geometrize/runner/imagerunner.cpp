@@ -1,9 +1,11 @@
 #include "imagerunner.h"
 
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include "../bitmap/bitmap.h"
+#include "../bitmap/bitmapview.h"
 #include "../core.h"
 #include "../model.h"
 #include "../shape/shapetypes.h"
@@ -16,6 +18,8 @@ class ImageRunner::ImageRunnerImpl
 {
 public:
     ImageRunnerImpl(const geometrize::Bitmap& targetBitmap) : m_model{targetBitmap} {}
+    ImageRunnerImpl(geometrize::Bitmap&& targetBitmap) : m_model{std::move(targetBitmap)} {}
+    ImageRunnerImpl(const geometrize::BitmapView& targetView) : m_model{targetView} {}
     ImageRunnerImpl(const geometrize::Bitmap& targetBitmap, const geometrize::Bitmap& initialBitmap) : m_model{targetBitmap, initialBitmap} {}
     ~ImageRunnerImpl() = default;
     ImageRunnerImpl& operator=(const ImageRunnerImpl&) = delete;
@@ -24,6 +28,8 @@ public:
     std::vector<geometrize::ShapeResult> step(const geometrize::ImageRunnerOptions& options)
     {
         m_model.setSeed(options.seed);
+        m_model.setCandidateBatchCount(options.candidateBatches);
+        m_model.setMomentTablesEnabled(options.useMomentTables);
         return m_model.step(options.shapeTypes, options.alpha, options.shapeCount, options.maxShapeMutations, options.maxThreads);
     }
 
@@ -60,6 +66,14 @@ ImageRunner::ImageRunner(const geometrize::Bitmap& targetBitmap) :
     d{std::unique_ptr<ImageRunner::ImageRunnerImpl>(new ImageRunner::ImageRunnerImpl(targetBitmap))}
 {}
 
+ImageRunner::ImageRunner(geometrize::Bitmap&& targetBitmap) :
+    d{std::unique_ptr<ImageRunner::ImageRunnerImpl>(new ImageRunner::ImageRunnerImpl(std::move(targetBitmap)))}
+{}
+
+ImageRunner::ImageRunner(const geometrize::BitmapView& targetView) :
+    d{std::unique_ptr<ImageRunner::ImageRunnerImpl>(new ImageRunner::ImageRunnerImpl(targetView))}
+{}
+
 ImageRunner::ImageRunner(const geometrize::Bitmap& targetBitmap,  const geometrize::Bitmap& initialBitmap) :
     d{std::unique_ptr<ImageRunner::ImageRunnerImpl>(new ImageRunner::ImageRunnerImpl(targetBitmap, initialBitmap))}
 {}
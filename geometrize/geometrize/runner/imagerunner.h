@@ -8,6 +8,7 @@
 namespace geometrize
 {
 class Bitmap;
+class BitmapView;
 class ImageRunnerOptions;
 class Model;
 }
@@ -17,6 +18,7 @@ namespace geometrize
 
 /**
  * @brief The ImageRunner class is a helper class for creating a set of primitives from a source image.
+ * A GRAY8 target bitmap gives a luminance-only run with gray shapes, see geometrize::Model.
  * @author Sam Twidale (http://samcodes.co.uk/)
  */
 class ImageRunner
@@ -28,9 +30,21 @@ public:
      */
     ImageRunner(const geometrize::Bitmap& targetBitmap);
 
+    /**
+     * @brief ImageRunner Creates an new image runner that takes the target bitmap's data instead of copying it. Uses the average color of the target as the starting image.
+     * @param targetBitmap The target bitmap to replicate with shapes.
+     */
+    ImageRunner(geometrize::Bitmap&& targetBitmap);
+
+    /**
+     * @brief ImageRunner Creates an new image runner from a view of the target pixel data, which is converted to RGBA8888 in a single pass. Uses the average color of the target as the starting image.
+     * @param targetView The view of the target pixel data to replicate with shapes.
+     */
+    ImageRunner(const geometrize::BitmapView& targetView);
+
     /**
      * @brief ImageRunner Creates an image runner with the given target bitmap, starting from the given initial bitmap.
-     * The target bitmap and initial bitmap must be the same size (width and height).
+     * The target bitmap and initial bitmap must be the same size (width and height) and format.
      * @param targetBitmap The target bitmap to replicate with shapes.
      * @param initialBitmap The starting bitmap.
      */
@@ -20,6 +20,8 @@ public:
     std::uint32_t maxShapeMutations = 100U; ///< The maximum number of times each candidate shape will be modified to attempt to find a better fit.
     std::uint32_t seed = 9001U; ///< The seed for the random number generators used by the image runner.
     std::uint32_t maxThreads = 0; ///< The maximum number of separate threads for the implementation to use. 0 lets the implementation choose a reasonable number.
+    std::uint32_t candidateBatches = 0U; ///< The number of batches the candidate shapes are split into and shared between threads, 0 for every thread to try shapeCount candidates. See Model::setCandidateBatchCount.
+    bool useMomentTables = false; ///< Whether the model should keep moment tables to score candidate shapes faster, at the cost of extra memory and slightly approximate scores. See Model::setMomentTablesEnabled.
 };
 
 }
@@ -1,5 +1,7 @@
 #include "circle.h"
 
+#include <cmath>
+#include <cassert>
 #include <cstdint>
 #include <memory>
 #include <sstream>
@@ -7,6 +9,7 @@
 #include "shape.h"
 #include "../model.h"
 #include "../commonutil.h"
+#include "../rasterizer/footprintcache.h"
 
 namespace geometrize
 {
@@ -18,37 +21,42 @@ Circle::Circle(const geometrize::Model& model) : Shape{model}
 
 std::shared_ptr<geometrize::Shape> Circle::clone() const
 {
-    std::shared_ptr<geometrize::Circle> circle{std::make_shared<geometrize::Circle>(m_model)};
-    circle->m_x = m_x;
-    circle->m_y = m_y;
-    circle->m_r = m_r;
-    return circle;
+    return std::make_shared<geometrize::Circle>(*this);
+}
+
+bool Circle::assign(const geometrize::Shape& other)
+{
+    assert(other.getType() == getType());
+    *this = static_cast<const geometrize::Circle&>(other);
+    return true;
 }
 
 std::vector<geometrize::Scanline> Circle::rasterize() const
 {
     std::vector<geometrize::Scanline> lines;
-    const std::int32_t xBound{m_model.getWidth()};
-    const std::int32_t yBound{m_model.getHeight()};
+    rasterize(lines);
+    return lines;
+}
 
+void Circle::rasterize(std::vector<geometrize::Scanline>& lines) const
+{
     const std::int32_t r{static_cast<std::int32_t>(m_r)};
-    for(std::int32_t y = -r; y <= r; y++) {
-        std::vector<std::int32_t> xScan;
-        for(std::int32_t x = -r; x <= r; x++) {
-            if(x * x + y * y <= r * r) {
-                xScan.push_back(x);
+    const std::int32_t parameters[geometrize::FootprintCache::maxParameters]{r, 0, 0};
+    geometrize::FootprintCache::rasterize(getType(), parameters, m_x, m_y, m_model.getWidth(), m_model.getHeight(), lines, [r](std::vector<geometrize::Scanline>& footprint) {
+        // Each row covers the pixels with x * x + y * y <= r * r, which run from -h to h where h is the integer square root of r * r - y * y
+        // Large circles are not cached, so the rows are worked out directly rather than by testing every pixel
+        for(std::int32_t y = -r; y <= r; y++) {
+            const std::int64_t span{static_cast<std::int64_t>(r) * r - static_cast<std::int64_t>(y) * y};
+            std::int64_t half{static_cast<std::int64_t>(std::sqrt(static_cast<double>(span)))};
+            while(half * half > span) {
+                half--;
             }
+            while((half + 1) * (half + 1) <= span) {
+                half++;
+            }
+            footprint.push_back(geometrize::Scanline(y, static_cast<std::int32_t>(-half), static_cast<std::int32_t>(half)));
         }
-
-        if(!xScan.empty()) {
-            const std::int32_t fy{m_y + y};
-            const std::int32_t x1{commonutil::clamp(m_x + xScan.front(), 0, xBound - 1)};
-            const std::int32_t x2{commonutil::clamp(m_x + xScan.back(), 0, xBound - 1)};
-            lines.push_back(geometrize::Scanline(fy, x1, x2));
-        }
-    }
-
-    return geometrize::Scanline::trim(lines, xBound, yBound);
+    });
 }
 
 void Circle::mutate()
@@ -56,6 +64,11 @@ void Circle::mutate()
     m_model.mutateShape(*this);
 }
 
+void Circle::mutate(geometrize::ShapeUndo& undo)
+{
+    m_model.mutateShape(*this, undo);
+}
+
 geometrize::ShapeTypes Circle::getType() const
 {
     return geometrize::ShapeTypes::CIRCLE;
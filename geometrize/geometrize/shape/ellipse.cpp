@@ -1,5 +1,6 @@
 #include "ellipse.h"
 
+#include <cassert>
 #include <cmath>
 #include <cstdint>
 #include <memory>
@@ -19,17 +20,26 @@ Ellipse::Ellipse(const geometrize::Model& model) : Shape{model}
 
 std::shared_ptr<geometrize::Shape> Ellipse::clone() const
 {
-    std::shared_ptr<geometrize::Ellipse> ellipse{std::make_shared<geometrize::Ellipse>(m_model)};
-    ellipse->m_x = m_x;
-    ellipse->m_y = m_y;
-    ellipse->m_rx = m_rx;
-    ellipse->m_ry = m_ry;
-    return ellipse;
+    return std::make_shared<geometrize::Ellipse>(*this);
+}
+
+bool Ellipse::assign(const geometrize::Shape& other)
+{
+    assert(other.getType() == getType());
+    *this = static_cast<const geometrize::Ellipse&>(other);
+    return true;
 }
 
 std::vector<geometrize::Scanline> Ellipse::rasterize() const
 {
     std::vector<geometrize::Scanline> lines;
+    rasterize(lines);
+    return lines;
+}
+
+void Ellipse::rasterize(std::vector<geometrize::Scanline>& lines) const
+{
+    lines.clear();
 
     const float aspect{static_cast<float>(m_rx) / static_cast<float>(m_ry)};
 
@@ -62,7 +72,7 @@ std::vector<geometrize::Scanline> Ellipse::rasterize() const
         }
     }
 
-    return geometrize::Scanline::trim(lines, m_model.getWidth(), m_model.getHeight());
+    geometrize::Scanline::trimInPlace(lines, m_model.getWidth(), m_model.getHeight());
 }
 
 void Ellipse::mutate()
@@ -70,6 +80,11 @@ void Ellipse::mutate()
     m_model.mutateShape(*this);
 }
 
+void Ellipse::mutate(geometrize::ShapeUndo& undo)
+{
+    m_model.mutateShape(*this, undo);
+}
+
 geometrize::ShapeTypes Ellipse::getType() const
 {
     return geometrize::ShapeTypes::ELLIPSE;
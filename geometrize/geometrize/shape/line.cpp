@@ -1,5 +1,6 @@
 #include "line.h"
 
+#include <cassert>
 #include <cstdint>
 #include <memory>
 #include <sstream>
@@ -21,27 +22,36 @@ Line::Line(const geometrize::Model& model) : Shape{model}
 
 std::shared_ptr<geometrize::Shape> Line::clone() const
 {
-    std::shared_ptr<geometrize::Line> line{std::make_shared<geometrize::Line>(m_model)};
-    line->m_x1 = m_x1;
-    line->m_y1 = m_y1;
-    line->m_x2 = m_x2;
-    line->m_y2 = m_y2;
-    return line;
+    return std::make_shared<geometrize::Line>(*this);
+}
+
+bool Line::assign(const geometrize::Shape& other)
+{
+    assert(other.getType() == getType());
+    *this = static_cast<const geometrize::Line&>(other);
+    return true;
 }
 
 std::vector<geometrize::Scanline> Line::rasterize() const
+{
+    std::vector<geometrize::Scanline> lines;
+    rasterize(lines);
+    return lines;
+}
+
+void Line::rasterize(std::vector<geometrize::Scanline>& lines) const
 {
     const std::int32_t xBound{m_model.getWidth()};
     const std::int32_t yBound{m_model.getHeight()};
 
-    std::vector<geometrize::Scanline> lines;
+    lines.clear();
 
-    const std::vector<std::pair<std::int32_t, std::int32_t>> points{geometrize::bresenham(m_x1, m_y1, m_x2, m_y2)};
-    for(const auto& point : points) {
-       lines.push_back(geometrize::Scanline(point.second, point.first, point.first));
-    }
+    geometrize::bresenham(m_x1, m_y1, m_x2, m_y2, [&lines](const std::int32_t x, const std::int32_t y) {
+        geometrize::Scanline::addPixel(lines, x, y);
+    });
 
-    return Scanline::trim(lines, xBound, yBound);
+    geometrize::Scanline::trimInPlace(lines, xBound, yBound);
+    geometrize::Scanline::coalesce(lines);
 }
 
 void Line::mutate()
@@ -49,6 +59,11 @@ void Line::mutate()
     m_model.mutateShape(*this);
 }
 
+void Line::mutate(geometrize::ShapeUndo& undo)
+{
+    m_model.mutateShape(*this, undo);
+}
+
 geometrize::ShapeTypes Line::getType() const
 {
     return geometrize::ShapeTypes::LINE;
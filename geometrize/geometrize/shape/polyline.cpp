@@ -1,5 +1,6 @@
 #include "polyline.h"
 
+#include <cassert>
 #include <cstdint>
 #include <memory>
 #include <sstream>
@@ -21,29 +22,41 @@ Polyline::Polyline(const geometrize::Model& model) : Shape{model}
 
 std::shared_ptr<geometrize::Shape> Polyline::clone() const
 {
-    std::shared_ptr<geometrize::Polyline> polyline{std::make_shared<geometrize::Polyline>(m_model)};
-    polyline->m_points = m_points;
-    return polyline;
+    return std::make_shared<geometrize::Polyline>(*this);
+}
+
+bool Polyline::assign(const geometrize::Shape& other)
+{
+    assert(other.getType() == getType());
+    *this = static_cast<const geometrize::Polyline&>(other);
+    return true;
 }
 
 std::vector<geometrize::Scanline> Polyline::rasterize() const
+{
+    std::vector<geometrize::Scanline> lines;
+    rasterize(lines);
+    return lines;
+}
+
+void Polyline::rasterize(std::vector<geometrize::Scanline>& lines) const
 {
     const std::int32_t xBound{m_model.getWidth()};
     const std::int32_t yBound{m_model.getHeight()};
 
-    std::vector<geometrize::Scanline> lines;
+    lines.clear();
 
     for(std::size_t i = 0; i < m_points.size(); i++) {
         const std::pair<std::int32_t, std::int32_t> p0{m_points[i]};
         const std::pair<std::int32_t, std::int32_t> p1{i < (m_points.size() - 1) ? m_points[i + 1] : m_points[i]};
 
-        const std::vector<std::pair<std::int32_t, std::int32_t>> points{geometrize::bresenham(p0.first, p0.second, p1.first, p1.second)};
-        for(const auto& point : points) {
-            lines.push_back(geometrize::Scanline(point.second, point.first, point.first));
-        }
+        geometrize::bresenham(p0.first, p0.second, p1.first, p1.second, [&lines](const std::int32_t x, const std::int32_t y) {
+            geometrize::Scanline::addPixel(lines, x, y);
+        });
     }
 
-    return Scanline::trim(lines, xBound, yBound);
+    geometrize::Scanline::trimInPlace(lines, xBound, yBound);
+    geometrize::Scanline::coalesce(lines);
 }
 
 void Polyline::mutate()
@@ -51,6 +64,11 @@ void Polyline::mutate()
     m_model.mutateShape(*this);
 }
 
+void Polyline::mutate(geometrize::ShapeUndo& undo)
+{
+    m_model.mutateShape(*this, undo);
+}
+
 geometrize::ShapeTypes Polyline::getType() const
 {
     return geometrize::ShapeTypes::POLYLINE;
@@ -27,8 +27,11 @@ public:
     Polyline(const geometrize::Model& model);
 
     virtual std::shared_ptr<geometrize::Shape> clone() const override;
+    virtual bool assign(const geometrize::Shape& other) override;
     virtual std::vector<geometrize::Scanline> rasterize() const override;
+    virtual void rasterize(std::vector<geometrize::Scanline>& lines) const override;
     virtual void mutate() override;
+    virtual void mutate(geometrize::ShapeUndo& undo) override;
     virtual geometrize::ShapeTypes getType() const override;
     virtual std::vector<std::int32_t> getRawShapeData() const override;
     virtual std::string getSvgShapeData() const override;
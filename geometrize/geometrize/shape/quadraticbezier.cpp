@@ -1,5 +1,6 @@
 #include "quadraticbezier.h"
 
+#include <cassert>
 #include <cstdint>
 #include <memory>
 #include <sstream>
@@ -20,44 +21,51 @@ QuadraticBezier::QuadraticBezier(const geometrize::Model& model) : Shape{model}
 
 std::shared_ptr<geometrize::Shape> QuadraticBezier::clone() const
 {
-    std::shared_ptr<geometrize::QuadraticBezier> bezier{std::make_shared<geometrize::QuadraticBezier>(m_model)};
-    bezier->m_x1 = m_x1;
-    bezier->m_y1 = m_y1;
-    bezier->m_cx = m_cx;
-    bezier->m_cy = m_cy;
-    bezier->m_x2 = m_x2;
-    bezier->m_y2 = m_y2;
-    return bezier;
+    return std::make_shared<geometrize::QuadraticBezier>(*this);
+}
+
+bool QuadraticBezier::assign(const geometrize::Shape& other)
+{
+    assert(other.getType() == getType());
+    *this = static_cast<const geometrize::QuadraticBezier&>(other);
+    return true;
 }
 
 std::vector<geometrize::Scanline> QuadraticBezier::rasterize() const
 {
-    std::vector<geometrize::Scanline> scanlines;
+    std::vector<geometrize::Scanline> lines;
+    rasterize(lines);
+    return lines;
+}
+
+void QuadraticBezier::rasterize(std::vector<geometrize::Scanline>& lines) const
+{
+    lines.clear();
 
     const std::int32_t xBound{m_model.getWidth()};
     const std::int32_t yBound{m_model.getHeight()};
 
-    std::vector<std::pair<std::int32_t, std::int32_t>> points;
     const std::uint32_t pointCount{20};
+    std::pair<std::int32_t, std::int32_t> points[pointCount + 1];
     for(std::uint32_t i = 0; i <= pointCount; i++) {
         const float t{static_cast<float>(i) / static_cast<float>(pointCount)};
         const float tp{1 - t};
         const std::int32_t x{static_cast<std::int32_t>(tp * (tp * m_x1 + (t * m_cx)) + t * ((tp * m_cx) + (t * m_x2)))};
         const std::int32_t y{static_cast<std::int32_t>(tp * (tp * m_y1 + (t * m_cy)) + t * ((tp * m_cy) + (t * m_y2)))};
-        points.push_back(std::make_pair(x, y));
+        points[i] = std::make_pair(x, y);
     }
 
-    for(std::uint32_t i = 0; i < points.size() - 1; i++) {
+    for(std::uint32_t i = 0; i < pointCount; i++) {
         const std::pair<std::int32_t, std::int32_t> p0{points[i]};
         const std::pair<std::int32_t, std::int32_t> p1{points[i + 1]};
 
-        const std::vector<std::pair<std::int32_t, std::int32_t>> points{geometrize::bresenham(p0.first, p0.second, p1.first, p1.second)};
-        for(const std::pair<std::int32_t, std::int32_t>& point : points) {
-            scanlines.push_back(geometrize::Scanline(point.second, point.first, point.first));
-        }
+        geometrize::bresenham(p0.first, p0.second, p1.first, p1.second, [&lines](const std::int32_t x, const std::int32_t y) {
+            geometrize::Scanline::addPixel(lines, x, y);
+        });
     }
 
-    return Scanline::trim(scanlines, xBound, yBound);
+    geometrize::Scanline::trimInPlace(lines, xBound, yBound);
+    geometrize::Scanline::coalesce(lines);
 }
 
 void QuadraticBezier::mutate()
@@ -65,6 +73,11 @@ void QuadraticBezier::mutate()
     m_model.mutateShape(*this);
 }
 
+void QuadraticBezier::mutate(geometrize::ShapeUndo& undo)
+{
+    m_model.mutateShape(*this, undo);
+}
+
 geometrize::ShapeTypes QuadraticBezier::getType() const
 {
     return geometrize::ShapeTypes::QUADRATIC_BEZIER;
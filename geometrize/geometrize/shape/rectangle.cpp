@@ -1,6 +1,7 @@
 #include "rectangle.h"
 
 #include <algorithm>
+#include <cassert>
 #include <cstdint>
 #include <memory>
 #include <sstream>
@@ -19,26 +20,35 @@ Rectangle::Rectangle(const geometrize::Model& model) : Shape{model}
 
 std::shared_ptr<geometrize::Shape> Rectangle::clone() const
 {
-    std::shared_ptr<geometrize::Rectangle> rect{std::make_shared<geometrize::Rectangle>(m_model)};
-    rect->m_x1 = m_x1;
-    rect->m_y1 = m_y1;
-    rect->m_x2 = m_x2;
-    rect->m_y2 = m_y2;
-    return rect;
+    return std::make_shared<geometrize::Rectangle>(*this);
+}
+
+bool Rectangle::assign(const geometrize::Shape& other)
+{
+    assert(other.getType() == getType());
+    *this = static_cast<const geometrize::Rectangle&>(other);
+    return true;
 }
 
 std::vector<geometrize::Scanline> Rectangle::rasterize() const
+{
+    std::vector<geometrize::Scanline> lines;
+    rasterize(lines);
+    return lines;
+}
+
+void Rectangle::rasterize(std::vector<geometrize::Scanline>& lines) const
 {
     const std::int32_t x1{(std::min)(m_x1, m_x2)};
     const std::int32_t x2{(std::max)(m_x1, m_x2)};
     const std::int32_t y1{(std::min)(m_y1, m_y2)};
     const std::int32_t y2{(std::max)(m_y1, m_y2)};
 
-    std::vector<geometrize::Scanline> lines;
+    lines.clear();
     for(std::int32_t y = y1; y < y2; y++) {
         lines.push_back(geometrize::Scanline(y, x1, x2));
     }
-    return geometrize::Scanline::trim(lines, m_model.getWidth(), m_model.getHeight());
+    geometrize::Scanline::trimInPlace(lines, m_model.getWidth(), m_model.getHeight());
 }
 
 void Rectangle::mutate()
@@ -46,6 +56,11 @@ void Rectangle::mutate()
     m_model.mutateShape(*this);
 }
 
+void Rectangle::mutate(geometrize::ShapeUndo& undo)
+{
+    m_model.mutateShape(*this, undo);
+}
+
 geometrize::ShapeTypes Rectangle::getType() const
 {
     return geometrize::ShapeTypes::RECTANGLE;
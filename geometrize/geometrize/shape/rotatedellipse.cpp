@@ -1,14 +1,46 @@
 #include "rotatedellipse.h"
 
+#include <algorithm>
+#include <cassert>
 #include <cmath>
 #include <cstdint>
 #include <memory>
 #include <sstream>
+#include <vector>
 
 #include "shape.h"
 #include "../model.h"
 #include "../commonutil.h"
-#include "../rasterizer/rasterizer.h"
+#include "../rasterizer/scanline.h"
+
+namespace
+{
+
+/**
+ * @brief The SinCosTable struct holds the sines and cosines of whole degree angles, which are all a rotated ellipse's angle can be.
+ */
+struct SinCosTable
+{
+    SinCosTable()
+    {
+        for(std::int32_t i = 0; i < 360; i++) {
+            const double rads{i * (3.14159265358979323846 / 180.0)};
+            sines[i] = static_cast<float>(std::sin(rads));
+            cosines[i] = static_cast<float>(std::cos(rads));
+        }
+    }
+
+    float sines[360];
+    float cosines[360];
+};
+
+const SinCosTable& getSinCosTable()
+{
+    static const SinCosTable table;
+    return table;
+}
+
+}
 
 namespace geometrize
 {
@@ -20,35 +52,67 @@ RotatedEllipse::RotatedEllipse(const geometrize::Model& model) : Shape{model}
 
 std::shared_ptr<geometrize::Shape> RotatedEllipse::clone() const
 {
-    std::shared_ptr<geometrize::RotatedEllipse> ellipse{std::make_shared<geometrize::RotatedEllipse>(m_model)};
-    ellipse->m_x = m_x;
-    ellipse->m_y = m_y;
-    ellipse->m_rx = m_rx;
-    ellipse->m_ry = m_ry;
-    ellipse->m_angle = m_angle;
-    return ellipse;
+    return std::make_shared<geometrize::RotatedEllipse>(*this);
+}
+
+bool RotatedEllipse::assign(const geometrize::Shape& other)
+{
+    assert(other.getType() == getType());
+    *this = static_cast<const geometrize::RotatedEllipse&>(other);
+    return true;
 }
 
 std::vector<geometrize::Scanline> RotatedEllipse::rasterize() const
 {
+    std::vector<geometrize::Scanline> lines;
+    rasterize(lines);
+    return lines;
+}
+
+void RotatedEllipse::rasterize(std::vector<geometrize::Scanline>& lines) const
+{
+    lines.clear();
+
     const std::int32_t w{m_model.getWidth()};
     const std::int32_t h{m_model.getHeight()};
+    if(m_rx <= 0 || m_ry <= 0) {
+        return;
+    }
 
-    const std::uint32_t pointCount{20};
-    std::vector<std::pair<std::int32_t, std::int32_t>> points;
-    const float rads{m_angle * (3.141f / 180.0f)};
-    const float c{std::cos(rads)};
-    const float s{std::sin(rads)};
-
-    for(std::uint32_t i = 0; i < pointCount; i++) {
-        const float angle{((360.0f / pointCount) * i) * (3.141f / 180.0f)};
-        const float crx{m_rx * std::cos(angle)};
-        const float cry{m_ry * std::sin(angle)};
-        points.push_back(std::make_pair(crx * c - cry * s + m_x, crx * s + cry * c + m_y));
+    const SinCosTable& table(getSinCosTable());
+    const std::int32_t degrees{((m_angle % 360) + 360) % 360};
+    const float c{table.cosines[degrees]};
+    const float s{table.sines[degrees]};
+
+    // A point (x, y) relative to the center is inside the ellipse when (xc + ys)^2 / rx^2 + (yc - xs)^2 / ry^2 <= 1
+    // For each row this is a quadratic ax^2 + bxy + dy^2 - 1 <= 0 in x, whose roots bound the span covered on that row
+    const float irx2{1.0f / (static_cast<float>(m_rx) * static_cast<float>(m_rx))};
+    const float iry2{1.0f / (static_cast<float>(m_ry) * static_cast<float>(m_ry))};
+    const float a{c * c * irx2 + s * s * iry2};
+    const float b{2.0f * c * s * (irx2 - iry2)};
+    const float d{s * s * irx2 + c * c * iry2};
+
+    // The vertical extent of the rotated ellipse
+    const float halfHeight{std::sqrt(static_cast<float>(m_rx) * m_rx * s * s + static_cast<float>(m_ry) * m_ry * c * c)};
+    const std::int32_t extent{static_cast<std::int32_t>(halfHeight)};
+    const std::int32_t yMin{(std::max)(m_y - extent, 0)};
+    const std::int32_t yMax{(std::min)(m_y + extent, h - 1)};
+
+    for(std::int32_t y = yMin; y <= yMax; y++) {
+        const float dy{static_cast<float>(y - m_y)};
+        const float by{b * dy};
+        const float discriminant{by * by - 4.0f * a * (d * dy * dy - 1.0f)};
+        if(discriminant < 0.0f) {
+            continue;
+        }
+        const float root{std::sqrt(discriminant)};
+        const float inverse{0.5f / a};
+        const std::int32_t x1{m_x + static_cast<std::int32_t>(std::ceil((-by - root) * inverse))};
+        const std::int32_t x2{m_x + static_cast<std::int32_t>(std::floor((-by + root) * inverse))};
+        lines.push_back(geometrize::Scanline(y, x1, x2));
     }
 
-    std::vector<geometrize::Scanline> scanlines{geometrize::scanlinesForPolygon(points)};
-    return geometrize::Scanline::trim(scanlines, w, h);
+    geometrize::Scanline::trimInPlace(lines, w, h);
 }
 
 void RotatedEllipse::mutate()
@@ -56,6 +120,11 @@ void RotatedEllipse::mutate()
     m_model.mutateShape(*this);
 }
 
+void RotatedEllipse::mutate(geometrize::ShapeUndo& undo)
+{
+    m_model.mutateShape(*this, undo);
+}
+
 geometrize::ShapeTypes RotatedEllipse::getType() const
 {
     return geometrize::ShapeTypes::ROTATED_ELLIPSE;
@@ -1,5 +1,6 @@
 #include "rotatedrectangle.h"
 
+#include <cassert>
 #include <cmath>
 #include <cstdint>
 #include <memory>
@@ -20,19 +21,29 @@ RotatedRectangle::RotatedRectangle(const geometrize::Model& model) : Shape{model
 
 std::shared_ptr<geometrize::Shape> RotatedRectangle::clone() const
 {
-    std::shared_ptr<geometrize::RotatedRectangle> rect{std::make_shared<geometrize::RotatedRectangle>(m_model)};
-    rect->m_x1 = m_x1;
-    rect->m_y1 = m_y1;
-    rect->m_x2 = m_x2;
-    rect->m_y2 = m_y2;
-    rect->m_angle = m_angle;
-    return rect;
+    return std::make_shared<geometrize::RotatedRectangle>(*this);
+}
+
+bool RotatedRectangle::assign(const geometrize::Shape& other)
+{
+    assert(other.getType() == getType());
+    *this = static_cast<const geometrize::RotatedRectangle&>(other);
+    return true;
 }
 
 std::vector<geometrize::Scanline> RotatedRectangle::rasterize() const
 {
-    std::vector<geometrize::Scanline> scanlines{geometrize::scanlinesForPolygon(getCornerPoints())};
-    return geometrize::Scanline::trim(scanlines, m_model.getWidth(), m_model.getHeight());
+    std::vector<geometrize::Scanline> lines;
+    rasterize(lines);
+    return lines;
+}
+
+void RotatedRectangle::rasterize(std::vector<geometrize::Scanline>& lines) const
+{
+    std::pair<std::int32_t, std::int32_t> corners[4];
+    getCornerPoints(corners);
+    geometrize::scanlinesForPolygon(corners, 4U, lines);
+    geometrize::Scanline::trimInPlace(lines, m_model.getWidth(), m_model.getHeight());
 }
 
 void RotatedRectangle::mutate()
@@ -40,7 +51,19 @@ void RotatedRectangle::mutate()
     m_model.mutateShape(*this);
 }
 
+void RotatedRectangle::mutate(geometrize::ShapeUndo& undo)
+{
+    m_model.mutateShape(*this, undo);
+}
+
 std::vector<std::pair<std::int32_t, std::int32_t>> RotatedRectangle::getCornerPoints() const
+{
+    std::pair<std::int32_t, std::int32_t> corners[4];
+    getCornerPoints(corners);
+    return {corners[0], corners[1], corners[2], corners[3]};
+}
+
+void RotatedRectangle::getCornerPoints(std::pair<std::int32_t, std::int32_t> (&corners)[4]) const
 {
     const std::int32_t x1{(std::min)(m_x1, m_x2)};
     const std::int32_t x2{(std::max)(m_x1, m_x2)};
@@ -64,7 +87,10 @@ std::vector<std::pair<std::int32_t, std::int32_t>> RotatedRectangle::getCornerPo
     const std::pair<std::int32_t, std::int32_t> ur{ox2 * c - oy1 * s + cx, ox2 * s + oy1 * c + cy};
     const std::pair<std::int32_t, std::int32_t> br{ox2 * c - oy2 * s + cx, ox2 * s + oy2 * c + cy};
 
-    return {ul, ur, br, bl};
+    corners[0] = ul;
+    corners[1] = ur;
+    corners[2] = br;
+    corners[3] = bl;
 }
 
 geometrize::ShapeTypes RotatedRectangle::getType() const
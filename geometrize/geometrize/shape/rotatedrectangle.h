@@ -27,14 +27,23 @@ public:
     RotatedRectangle(const geometrize::Model& model);
 
     virtual std::shared_ptr<geometrize::Shape> clone() const override;
+    virtual bool assign(const geometrize::Shape& other) override;
     virtual std::vector<geometrize::Scanline> rasterize() const override;
+    virtual void rasterize(std::vector<geometrize::Scanline>& lines) const override;
     virtual void mutate() override;
+    virtual void mutate(geometrize::ShapeUndo& undo) override;
     virtual geometrize::ShapeTypes getType() const override;
     virtual std::vector<std::int32_t> getRawShapeData() const override;
     virtual std::string getSvgShapeData() const override;
 
     std::vector<std::pair<std::int32_t, std::int32_t>> getCornerPoints() const;
 
+    /**
+     * @brief getCornerPoints Gets the corner points of the rotated rectangle without allocating, in the same order as the vector-returning version.
+     * @param corners The array to write the upper-left, upper-right, bottom-right and bottom-left corners to.
+     */
+    void getCornerPoints(std::pair<std::int32_t, std::int32_t> (&corners)[4]) const;
+
     std::int32_t m_x1; ///< Left coordinate.
     std::int32_t m_y1; ///< Top coordinate.
     std::int32_t m_x2; ///< Right coordinate.
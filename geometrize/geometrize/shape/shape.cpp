@@ -1,8 +1,11 @@
 #include "shape.h"
 
+#include <cassert>
 #include <string>
+#include <vector>
 
 #include "../model.h"
+#include "shapeundo.h"
 
 namespace geometrize
 {
@@ -11,6 +14,29 @@ Shape::Shape(const geometrize::Model& model) : m_model(model)
 {
 }
 
+Shape& Shape::operator=(const geometrize::Shape& other)
+{
+    // The model cannot be reassigned, so there is nothing to copy here - subclasses copy their geometry
+    assert(&m_model == &other.m_model && "Shapes can only be assigned to shapes created by the same model");
+    return *this;
+}
+
+bool Shape::assign(const geometrize::Shape&)
+{
+    return false;
+}
+
+void Shape::rasterize(std::vector<geometrize::Scanline>& lines) const
+{
+    lines = rasterize();
+}
+
+void Shape::mutate(geometrize::ShapeUndo& undo)
+{
+    undo.beginUnrecorded();
+    mutate();
+}
+
 const Model& Shape::getModel()
 {
     return m_model;
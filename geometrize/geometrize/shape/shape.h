@@ -10,6 +10,7 @@
 namespace geometrize
 {
 class Model;
+class ShapeUndo;
 }
 
 namespace geometrize
@@ -24,7 +25,7 @@ class Shape
 public:
     Shape(const geometrize::Model& model);
      ~Shape() = default;
-    Shape& operator=(const geometrize::Shape& other) = default;
+    Shape& operator=(const geometrize::Shape& other);
     Shape(const geometrize::Shape& other) = default;
 
     /**
@@ -33,18 +34,42 @@ public:
      */
     virtual std::shared_ptr<geometrize::Shape> clone() const = 0;
 
+    /**
+     * @brief assign Copies the geometry of another shape into this one, a virtual assignment operator.
+     * Unlike clone this does not allocate, so it is used to copy candidate shapes around while hill climbing.
+     * The built-in shapes all override this. The default does nothing and returns false, so shapes defined elsewhere keep working, and are copied with clone instead.
+     * @param other The shape to copy. Must be the same type of shape, and created by the same model.
+     * @return True if the shape was copied, false if it should be copied with clone instead.
+     */
+    virtual bool assign(const geometrize::Shape& other);
+
     /**
      * @brief rasterize Creates a raster scanline representation of the shape.
      * @return Raster scanlines representing the shape.
      */
     virtual std::vector<geometrize::Scanline> rasterize() const = 0;
 
+    /**
+     * @brief rasterize Creates a raster scanline representation of the shape, replacing the contents of the given vector.
+     * Reusing the same vector between calls avoids allocating once it has grown large enough.
+     * The built-in shapes override this, the default copies the result of rasterize() so shapes defined elsewhere keep working.
+     * @param lines The vector to write the raster scanlines representing the shape to.
+     */
+    virtual void rasterize(std::vector<geometrize::Scanline>& lines) const;
+
     /**
      * @brief mutate Modifies the shape a little, typically using a random component.
      * Used to improve the shape's fit in a bitmap.
      */
     virtual void mutate() = 0;
 
+    /**
+     * @brief mutate Modifies the shape a little, recording what changed so the mutation can be reverted cheaply.
+     * The default marks the record as unrecorded and calls mutate(), so shapes defined elsewhere keep working, and are restored by copying instead.
+     * @param undo The record of the changes made. Only the default mutators record their changes, check ShapeUndo::isComplete before reverting.
+     */
+    virtual void mutate(geometrize::ShapeUndo& undo);
+
     /**
      * @brief getType Gets the ShapeType of the shape.
      * @return The ShapeType of the shape.
@@ -8,6 +8,7 @@
 #include "rectangle.h"
 #include "rotatedellipse.h"
 #include "rotatedrectangle.h"
+#include "shapeundo.h"
 #include "triangle.h"
 
 #include "../commonutil.h"
@@ -43,11 +44,13 @@ void setupLine(geometrize::Line& shape)
     const std::int32_t yBound{shape.m_model.getHeight()};
 
     const std::pair<std::int32_t, std::int32_t> startingPoint{std::make_pair(geometrize::commonutil::randomRange(0, xBound), geometrize::commonutil::randomRange(0, yBound - 1))};
+    std::int32_t offsets[4];
+    geometrize::commonutil::randomRange(-32, 32, offsets, 4U);
 
-    shape.m_x1 = geometrize::commonutil::clamp(startingPoint.first + geometrize::commonutil::randomRange(-32, 32), 0, xBound - 1);
-    shape.m_y1 = geometrize::commonutil::clamp(startingPoint.second + geometrize::commonutil::randomRange(-32, 32), 0, yBound - 1);
-    shape.m_x2 = geometrize::commonutil::clamp(startingPoint.first + geometrize::commonutil::randomRange(-32, 32), 0, xBound - 1);
-    shape.m_y2 = geometrize::commonutil::clamp(startingPoint.second + geometrize::commonutil::randomRange(-32, 32), 0, yBound - 1);
+    shape.m_x1 = geometrize::commonutil::clamp(startingPoint.first + offsets[0], 0, xBound - 1);
+    shape.m_y1 = geometrize::commonutil::clamp(startingPoint.second + offsets[1], 0, yBound - 1);
+    shape.m_x2 = geometrize::commonutil::clamp(startingPoint.first + offsets[2], 0, xBound - 1);
+    shape.m_y2 = geometrize::commonutil::clamp(startingPoint.second + offsets[3], 0, yBound - 1);
 }
 
 void setupPolyline(geometrize::Polyline& shape)
@@ -56,10 +59,12 @@ void setupPolyline(geometrize::Polyline& shape)
     const std::int32_t yBound{shape.m_model.getHeight()};
 
     const std::pair<std::int32_t, std::int32_t> startingPoint{std::make_pair(geometrize::commonutil::randomRange(0, xBound), geometrize::commonutil::randomRange(0, yBound - 1))};
+    std::int32_t offsets[8];
+    geometrize::commonutil::randomRange(-32, 32, offsets, 8U);
     for(std::int32_t i = 0; i < 4; i++) {
         const std::pair<std::int32_t, std::int32_t> point{
-            geometrize::commonutil::clamp(startingPoint.first + geometrize::commonutil::randomRange(-32, 32), 0, xBound - 1),
-            geometrize::commonutil::clamp(startingPoint.second + geometrize::commonutil::randomRange(-32, 32), 0, yBound - 1)
+            geometrize::commonutil::clamp(startingPoint.first + offsets[i * 2], 0, xBound - 1),
+            geometrize::commonutil::clamp(startingPoint.second + offsets[i * 2 + 1], 0, yBound - 1)
         };
         shape.m_points.push_back(point);
     }
@@ -120,13 +125,15 @@ void setupTriangle(geometrize::Triangle& shape)
 
     shape.m_x1 = geometrize::commonutil::randomRange(0, xBound - 1);
     shape.m_y1 = geometrize::commonutil::randomRange(0, yBound - 1);
-    shape.m_x2 = shape.m_x1 + geometrize::commonutil::randomRange(-32, 32);
-    shape.m_y2 = shape.m_y1 + geometrize::commonutil::randomRange(-32, 32);
-    shape.m_x3 = shape.m_x1 + geometrize::commonutil::randomRange(-32, 32);
-    shape.m_y3 = shape.m_y1 + geometrize::commonutil::randomRange(-32, 32);
+    std::int32_t offsets[4];
+    geometrize::commonutil::randomRange(-32, 32, offsets, 4U);
+    shape.m_x2 = shape.m_x1 + offsets[0];
+    shape.m_y2 = shape.m_y1 + offsets[1];
+    shape.m_x3 = shape.m_x1 + offsets[2];
+    shape.m_y3 = shape.m_y1 + offsets[3];
 }
 
-void mutateCircle(geometrize::Circle& shape)
+inline void mutateAndRecord(geometrize::Circle& shape, geometrize::ShapeUndo& undo)
 {
     const std::int32_t xBound{shape.m_model.getWidth()};
     const std::int32_t yBound{shape.m_model.getHeight()};
@@ -135,19 +142,22 @@ void mutateCircle(geometrize::Circle& shape)
     switch(r) {
         case 0:
         {
+            undo.record(shape.m_x);
             shape.m_x = geometrize::commonutil::clamp(shape.m_x + geometrize::commonutil::randomRange(-16, 16), 0, xBound - 1);
+            undo.record(shape.m_y);
             shape.m_y = geometrize::commonutil::clamp(shape.m_y + geometrize::commonutil::randomRange(-16, 16), 0, yBound - 1);
             break;
         }
         case 1:
         {
+            undo.record(shape.m_r);
             shape.m_r = geometrize::commonutil::clamp(shape.m_r + geometrize::commonutil::randomRange(-16, 16), 1, xBound - 1);
             break;
         }
     }
 }
 
-void mutateEllipse(geometrize::Ellipse& shape)
+inline void mutateAndRecord(geometrize::Ellipse& shape, geometrize::ShapeUndo& undo)
 {
     const std::int32_t xBound{shape.m_model.getWidth()};
     const std::int32_t yBound{shape.m_model.getHeight()};
@@ -156,24 +166,28 @@ void mutateEllipse(geometrize::Ellipse& shape)
     switch(r) {
         case 0:
         {
+            undo.record(shape.m_x);
             shape.m_x = geometrize::commonutil::clamp(shape.m_x + geometrize::commonutil::randomRange(-16, 16), 0, xBound - 1);
+            undo.record(shape.m_y);
             shape.m_y = geometrize::commonutil::clamp(shape.m_y + geometrize::commonutil::randomRange(-16, 16), 0, yBound - 1);
             break;
         }
         case 1:
         {
+            undo.record(shape.m_rx);
             shape.m_rx = geometrize::commonutil::clamp(shape.m_rx + geometrize::commonutil::randomRange(-16, 16), 1, xBound - 1);
             break;
         }
         case 2:
         {
+            undo.record(shape.m_ry);
             shape.m_ry = geometrize::commonutil::clamp(shape.m_ry + geometrize::commonutil::randomRange(-16, 16), 1, yBound - 1);
             break;
         }
     }
 }
 
-void mutateLine(geometrize::Line& shape)
+inline void mutateAndRecord(geometrize::Line& shape, geometrize::ShapeUndo& undo)
 {
     const std::int32_t xBound{shape.m_model.getWidth()};
     const std::int32_t yBound{shape.m_model.getHeight()};
@@ -183,20 +197,24 @@ void mutateLine(geometrize::Line& shape)
     switch(r) {
         case 0:
         {
+            undo.record(shape.m_x1);
             shape.m_x1 = geometrize::commonutil::clamp(shape.m_x1 + geometrize::commonutil::randomRange(-16, 16), 0, xBound - 1);
+            undo.record(shape.m_y1);
             shape.m_y1 = geometrize::commonutil::clamp(shape.m_y1 + geometrize::commonutil::randomRange(-16, 16), 0, yBound - 1);
             break;
         }
         case 1:
         {
+            undo.record(shape.m_x2);
             shape.m_x2 = geometrize::commonutil::clamp(shape.m_x2 + geometrize::commonutil::randomRange(-16, 16), 0, xBound - 1);
+            undo.record(shape.m_y2);
             shape.m_y2 = geometrize::commonutil::clamp(shape.m_y2 + geometrize::commonutil::randomRange(-16, 16), 0, yBound - 1);
             break;
         }
     }
 }
 
-void mutatePolyline(geometrize::Polyline& shape)
+inline void mutateAndRecord(geometrize::Polyline& shape, geometrize::ShapeUndo& undo)
 {
     const std::int32_t xBound{shape.m_model.getWidth()};
     const std::int32_t yBound{shape.m_model.getHeight()};
@@ -206,10 +224,12 @@ void mutatePolyline(geometrize::Polyline& shape)
     point.first = geometrize::commonutil::clamp(point.first + geometrize::commonutil::randomRange(-64, 64), 0, xBound - 1);
     point.second = geometrize::commonutil::clamp(point.second + geometrize::commonutil::randomRange(-64, 64), 0, yBound - 1);
 
+    undo.record(shape.m_points[i].first);
+    undo.record(shape.m_points[i].second);
     shape.m_points[i] = point;
 }
 
-void mutateQuadraticBezier(geometrize::QuadraticBezier& shape)
+inline void mutateAndRecord(geometrize::QuadraticBezier& shape, geometrize::ShapeUndo& undo)
 {
     const std::int32_t xBound{shape.m_model.getWidth()};
     const std::int32_t yBound{shape.m_model.getHeight()};
@@ -218,26 +238,32 @@ void mutateQuadraticBezier(geometrize::QuadraticBezier& shape)
     switch(r) {
         case 0:
         {
+            undo.record(shape.m_cx);
             shape.m_cx = geometrize::commonutil::clamp(shape.m_cx + geometrize::commonutil::randomRange(-8, 8), 0, xBound - 1);
+            undo.record(shape.m_cy);
             shape.m_cy = geometrize::commonutil::clamp(shape.m_cy + geometrize::commonutil::randomRange(-8, 8), 0, yBound - 1);
             break;
         }
         case 1:
         {
+            undo.record(shape.m_x1);
             shape.m_x1 = geometrize::commonutil::clamp(shape.m_x1 + geometrize::commonutil::randomRange(-8, 8), 1, xBound - 1);
+            undo.record(shape.m_y1);
             shape.m_y1 = geometrize::commonutil::clamp(shape.m_y1 + geometrize::commonutil::randomRange(-8, 8), 1, yBound - 1);
             break;
         }
         case 2:
         {
+            undo.record(shape.m_x2);
             shape.m_x2 = geometrize::commonutil::clamp(shape.m_x2 + geometrize::commonutil::randomRange(-8, 8), 1, xBound - 1);
+            undo.record(shape.m_y2);
             shape.m_y2 = geometrize::commonutil::clamp(shape.m_y2 + geometrize::commonutil::randomRange(-8, 8), 1, yBound - 1);
             break;
         }
     }
 }
 
-void mutateRectangle(geometrize::Rectangle& shape)
+inline void mutateAndRecord(geometrize::Rectangle& shape, geometrize::ShapeUndo& undo)
 {
     const std::int32_t xBound{shape.m_model.getWidth()};
     const std::int32_t yBound{shape.m_model.getHeight()};
@@ -246,20 +272,24 @@ void mutateRectangle(geometrize::Rectangle& shape)
     switch(r) {
         case 0:
         {
+            undo.record(shape.m_x1);
             shape.m_x1 = geometrize::commonutil::clamp(shape.m_x1 + geometrize::commonutil::randomRange(-16, 16), 0, xBound - 1);
+            undo.record(shape.m_y1);
             shape.m_y1 = geometrize::commonutil::clamp(shape.m_y1 + geometrize::commonutil::randomRange(-16, 16), 0, yBound - 1);
             break;
         }
         case 1:
         {
+            undo.record(shape.m_x2);
             shape.m_x2 = geometrize::commonutil::clamp(shape.m_x2 + geometrize::commonutil::randomRange(-16, 16), 0, xBound - 1);
+            undo.record(shape.m_y2);
             shape.m_y2 = geometrize::commonutil::clamp(shape.m_y2 + geometrize::commonutil::randomRange(-16, 16), 0, yBound - 1);
             break;
         }
     }
 }
 
-void mutateRotatedEllipse(geometrize::RotatedEllipse& shape)
+inline void mutateAndRecord(geometrize::RotatedEllipse& shape, geometrize::ShapeUndo& undo)
 {
     const std::int32_t xBound{shape.m_model.getWidth()};
     const std::int32_t yBound{shape.m_model.getHeight()};
@@ -268,29 +298,34 @@ void mutateRotatedEllipse(geometrize::RotatedEllipse& shape)
     switch(r) {
         case 0:
         {
+            undo.record(shape.m_x);
             shape.m_x = geometrize::commonutil::clamp(shape.m_x + geometrize::commonutil::randomRange(-16, 16), 0, xBound - 1);
+            undo.record(shape.m_y);
             shape.m_y = geometrize::commonutil::clamp(shape.m_y + geometrize::commonutil::randomRange(-16, 16), 0, yBound - 1);
             break;
         }
         case 1:
         {
+            undo.record(shape.m_rx);
             shape.m_rx = geometrize::commonutil::clamp(shape.m_rx + geometrize::commonutil::randomRange(-16, 16), 1, xBound - 1);
             break;
         }
         case 2:
         {
+            undo.record(shape.m_ry);
             shape.m_ry = geometrize::commonutil::clamp(shape.m_ry + geometrize::commonutil::randomRange(-16, 16), 1, yBound - 1);
             break;
         }
         case 3:
         {
+            undo.record(shape.m_angle);
             shape.m_angle = geometrize::commonutil::clamp(shape.m_angle + geometrize::commonutil::randomRange(-16, 16), 0, 360);
             break;
         }
     }
 }
 
-void mutateRotatedRectangle(geometrize::RotatedRectangle& shape)
+inline void mutateAndRecord(geometrize::RotatedRectangle& shape, geometrize::ShapeUndo& undo)
 {
     const std::int32_t xBound{shape.m_model.getWidth()};
     const std::int32_t yBound{shape.m_model.getHeight()};
@@ -299,25 +334,30 @@ void mutateRotatedRectangle(geometrize::RotatedRectangle& shape)
     switch(r) {
         case 0:
         {
+            undo.record(shape.m_x1);
             shape.m_x1 = geometrize::commonutil::clamp(shape.m_x1 + geometrize::commonutil::randomRange(-16, 16), 0, xBound);
+            undo.record(shape.m_y1);
             shape.m_y1 = geometrize::commonutil::clamp(shape.m_y1 + geometrize::commonutil::randomRange(-16, 16), 0, yBound);
             break;
         }
         case 1:
         {
+            undo.record(shape.m_x2);
             shape.m_x2 = geometrize::commonutil::clamp(shape.m_x2 + geometrize::commonutil::randomRange(-16, 16), 0, xBound);
+            undo.record(shape.m_y2);
             shape.m_y2 = geometrize::commonutil::clamp(shape.m_y2 + geometrize::commonutil::randomRange(-16, 16), 0, yBound);
             break;
         }
         case 2:
         {
+            undo.record(shape.m_angle);
             shape.m_angle = geometrize::commonutil::clamp(shape.m_angle + geometrize::commonutil::randomRange(-4, 4), 0, 360);
             break;
         }
     }
 }
 
-void mutateTriangle(geometrize::Triangle& shape)
+inline void mutateAndRecord(geometrize::Triangle& shape, geometrize::ShapeUndo& undo)
 {
     const std::int32_t xBound{shape.m_model.getWidth()};
     const std::int32_t yBound{shape.m_model.getHeight()};
@@ -326,25 +366,85 @@ void mutateTriangle(geometrize::Triangle& shape)
     switch(r) {
         case 0:
         {
+            undo.record(shape.m_x1);
             shape.m_x1 = geometrize::commonutil::clamp(shape.m_x1 + geometrize::commonutil::randomRange(-32, 32), 0, xBound);
+            undo.record(shape.m_y1);
             shape.m_y1 = geometrize::commonutil::clamp(shape.m_y1 + geometrize::commonutil::randomRange(-32, 32), 0, yBound);
             break;
         }
         case 1:
         {
+            undo.record(shape.m_x2);
             shape.m_x2 = geometrize::commonutil::clamp(shape.m_x2 + geometrize::commonutil::randomRange(-32, 32), 0, xBound);
+            undo.record(shape.m_y2);
             shape.m_y2 = geometrize::commonutil::clamp(shape.m_y2 + geometrize::commonutil::randomRange(-32, 32), 0, yBound);
             break;
         }
         case 2:
         {
+            undo.record(shape.m_x3);
             shape.m_x3 = geometrize::commonutil::clamp(shape.m_x3 + geometrize::commonutil::randomRange(-32, 32), 0, xBound);
+            undo.record(shape.m_y3);
             shape.m_y3 = geometrize::commonutil::clamp(shape.m_y3 + geometrize::commonutil::randomRange(-32, 32), 0, yBound);
             break;
         }
     }
 }
 
+void mutateCircle(geometrize::Circle& shape)
+{
+    geometrize::ShapeUndo undo;
+    mutateAndRecord(shape, undo);
+}
+
+void mutateEllipse(geometrize::Ellipse& shape)
+{
+    geometrize::ShapeUndo undo;
+    mutateAndRecord(shape, undo);
+}
+
+void mutateLine(geometrize::Line& shape)
+{
+    geometrize::ShapeUndo undo;
+    mutateAndRecord(shape, undo);
+}
+
+void mutatePolyline(geometrize::Polyline& shape)
+{
+    geometrize::ShapeUndo undo;
+    mutateAndRecord(shape, undo);
+}
+
+void mutateQuadraticBezier(geometrize::QuadraticBezier& shape)
+{
+    geometrize::ShapeUndo undo;
+    mutateAndRecord(shape, undo);
+}
+
+void mutateRectangle(geometrize::Rectangle& shape)
+{
+    geometrize::ShapeUndo undo;
+    mutateAndRecord(shape, undo);
+}
+
+void mutateRotatedEllipse(geometrize::RotatedEllipse& shape)
+{
+    geometrize::ShapeUndo undo;
+    mutateAndRecord(shape, undo);
+}
+
+void mutateRotatedRectangle(geometrize::RotatedRectangle& shape)
+{
+    geometrize::ShapeUndo undo;
+    mutateAndRecord(shape, undo);
+}
+
+void mutateTriangle(geometrize::Triangle& shape)
+{
+    geometrize::ShapeUndo undo;
+    mutateAndRecord(shape, undo);
+}
+
 ShapeMutator::ShapeMutator()
 {
     setDefaults();
@@ -371,6 +471,16 @@ void ShapeMutator::setDefaults()
     m_mutateRotatedEllipse = mutateRotatedEllipse;
     m_mutateRotatedRectangle = mutateRotatedRectangle;
     m_mutateTriangle = mutateTriangle;
+
+    m_defaultMutateCircle = true;
+    m_defaultMutateEllipse = true;
+    m_defaultMutateLine = true;
+    m_defaultMutatePolyline = true;
+    m_defaultMutateQuadraticBezier = true;
+    m_defaultMutateRectangle = true;
+    m_defaultMutateRotatedEllipse = true;
+    m_defaultMutateRotatedRectangle = true;
+    m_defaultMutateTriangle = true;
 }
 
 void ShapeMutator::setup(geometrize::Circle& shape) const
@@ -383,6 +493,17 @@ void ShapeMutator::mutate(geometrize::Circle& shape) const
     m_mutateCircle(shape);
 }
 
+void ShapeMutator::mutate(geometrize::Circle& shape, geometrize::ShapeUndo& undo) const
+{
+    if(m_defaultMutateCircle) {
+        undo.begin();
+        mutateAndRecord(shape, undo);
+    } else {
+        undo.beginUnrecorded();
+        m_mutateCircle(shape);
+    }
+}
+
 void ShapeMutator::setSetupFunction(const std::function<void(geometrize::Circle&)>& f)
 {
     m_setupCircle = f;
@@ -391,6 +512,7 @@ void ShapeMutator::setSetupFunction(const std::function<void(geometrize::Circle&
 void ShapeMutator::setMutatorFunction(const std::function<void(geometrize::Circle&)>& f)
 {
     m_mutateCircle = f;
+    m_defaultMutateCircle = false;
 }
 
 void ShapeMutator::setup(geometrize::Ellipse& shape) const
@@ -403,6 +525,17 @@ void ShapeMutator::mutate(geometrize::Ellipse& shape) const
     m_mutateEllipse(shape);
 }
 
+void ShapeMutator::mutate(geometrize::Ellipse& shape, geometrize::ShapeUndo& undo) const
+{
+    if(m_defaultMutateEllipse) {
+        undo.begin();
+        mutateAndRecord(shape, undo);
+    } else {
+        undo.beginUnrecorded();
+        m_mutateEllipse(shape);
+    }
+}
+
 void ShapeMutator::setSetupFunction(const std::function<void(geometrize::Ellipse&)>& f)
 {
     m_setupEllipse = f;
@@ -411,6 +544,7 @@ void ShapeMutator::setSetupFunction(const std::function<void(geometrize::Ellipse
 void ShapeMutator::setMutatorFunction(const std::function<void(geometrize::Ellipse&)>& f)
 {
     m_mutateEllipse = f;
+    m_defaultMutateEllipse = false;
 }
 
 void ShapeMutator::setup(geometrize::Line& shape) const
@@ -423,6 +557,17 @@ void ShapeMutator::mutate(geometrize::Line& shape) const
     m_mutateLine(shape);
 }
 
+void ShapeMutator::mutate(geometrize::Line& shape, geometrize::ShapeUndo& undo) const
+{
+    if(m_defaultMutateLine) {
+        undo.begin();
+        mutateAndRecord(shape, undo);
+    } else {
+        undo.beginUnrecorded();
+        m_mutateLine(shape);
+    }
+}
+
 void ShapeMutator::setSetupFunction(const std::function<void(geometrize::Line&)>& f)
 {
     m_setupLine = f;
@@ -431,6 +576,7 @@ void ShapeMutator::setSetupFunction(const std::function<void(geometrize::Line&)>
 void ShapeMutator::setMutatorFunction(const std::function<void(geometrize::Line&)>& f)
 {
     m_mutateLine = f;
+    m_defaultMutateLine = false;
 }
 
 void ShapeMutator::setup(geometrize::Polyline& shape) const
@@ -443,6 +589,17 @@ void ShapeMutator::mutate(geometrize::Polyline& shape) const
     m_mutatePolyline(shape);
 }
 
+void ShapeMutator::mutate(geometrize::Polyline& shape, geometrize::ShapeUndo& undo) const
+{
+    if(m_defaultMutatePolyline) {
+        undo.begin();
+        mutateAndRecord(shape, undo);
+    } else {
+        undo.beginUnrecorded();
+        m_mutatePolyline(shape);
+    }
+}
+
 void ShapeMutator::setSetupFunction(const std::function<void(geometrize::Polyline&)>& f)
 {
     m_setupPolyline = f;
@@ -451,6 +608,7 @@ void ShapeMutator::setSetupFunction(const std::function<void(geometrize::Polylin
 void ShapeMutator::setMutatorFunction(const std::function<void(geometrize::Polyline&)>& f)
 {
     m_mutatePolyline = f;
+    m_defaultMutatePolyline = false;
 }
 
 void ShapeMutator::setup(geometrize::QuadraticBezier& shape) const
@@ -463,6 +621,17 @@ void ShapeMutator::mutate(geometrize::QuadraticBezier& shape) const
     m_mutateQuadraticBezier(shape);
 }
 
+void ShapeMutator::mutate(geometrize::QuadraticBezier& shape, geometrize::ShapeUndo& undo) const
+{
+    if(m_defaultMutateQuadraticBezier) {
+        undo.begin();
+        mutateAndRecord(shape, undo);
+    } else {
+        undo.beginUnrecorded();
+        m_mutateQuadraticBezier(shape);
+    }
+}
+
 void ShapeMutator::setSetupFunction(const std::function<void(geometrize::QuadraticBezier&)>& f)
 {
     m_setupQuadraticBezier = f;
@@ -471,6 +640,7 @@ void ShapeMutator::setSetupFunction(const std::function<void(geometrize::Quadrat
 void ShapeMutator::setMutatorFunction(const std::function<void(geometrize::QuadraticBezier&)>& f)
 {
     m_mutateQuadraticBezier = f;
+    m_defaultMutateQuadraticBezier = false;
 }
 
 void ShapeMutator::setup(geometrize::Rectangle& shape) const
@@ -483,6 +653,17 @@ void ShapeMutator::mutate(geometrize::Rectangle& shape) const
     m_mutateRectangle(shape);
 }
 
+void ShapeMutator::mutate(geometrize::Rectangle& shape, geometrize::ShapeUndo& undo) const
+{
+    if(m_defaultMutateRectangle) {
+        undo.begin();
+        mutateAndRecord(shape, undo);
+    } else {
+        undo.beginUnrecorded();
+        m_mutateRectangle(shape);
+    }
+}
+
 void ShapeMutator::setSetupFunction(const std::function<void(geometrize::Rectangle&)>& f)
 {
     m_setupRectangle = f;
@@ -491,6 +672,7 @@ void ShapeMutator::setSetupFunction(const std::function<void(geometrize::Rectang
 void ShapeMutator::setMutatorFunction(const std::function<void(geometrize::Rectangle&)>& f)
 {
     m_mutateRectangle = f;
+    m_defaultMutateRectangle = false;
 }
 
 void ShapeMutator::setup(geometrize::RotatedEllipse& shape) const
@@ -503,6 +685,17 @@ void ShapeMutator::mutate(geometrize::RotatedEllipse& shape) const
     m_mutateRotatedEllipse(shape);
 }
 
+void ShapeMutator::mutate(geometrize::RotatedEllipse& shape, geometrize::ShapeUndo& undo) const
+{
+    if(m_defaultMutateRotatedEllipse) {
+        undo.begin();
+        mutateAndRecord(shape, undo);
+    } else {
+        undo.beginUnrecorded();
+        m_mutateRotatedEllipse(shape);
+    }
+}
+
 void ShapeMutator::setSetupFunction(const std::function<void(geometrize::RotatedEllipse&)>& f)
 {
     m_setupRotatedEllipse = f;
@@ -511,6 +704,7 @@ void ShapeMutator::setSetupFunction(const std::function<void(geometrize::Rotated
 void ShapeMutator::setMutatorFunction(const std::function<void(geometrize::RotatedEllipse&)>& f)
 {
     m_mutateRotatedEllipse = f;
+    m_defaultMutateRotatedEllipse = false;
 }
 
 void ShapeMutator::setup(geometrize::RotatedRectangle& shape) const
@@ -523,6 +717,17 @@ void ShapeMutator::mutate(geometrize::RotatedRectangle& shape) const
     m_mutateRotatedRectangle(shape);
 }
 
+void ShapeMutator::mutate(geometrize::RotatedRectangle& shape, geometrize::ShapeUndo& undo) const
+{
+    if(m_defaultMutateRotatedRectangle) {
+        undo.begin();
+        mutateAndRecord(shape, undo);
+    } else {
+        undo.beginUnrecorded();
+        m_mutateRotatedRectangle(shape);
+    }
+}
+
 void ShapeMutator::setSetupFunction(const std::function<void(geometrize::RotatedRectangle&)>& f)
 {
     m_setupRotatedRectangle = f;
@@ -531,6 +736,7 @@ void ShapeMutator::setSetupFunction(const std::function<void(geometrize::Rotated
 void ShapeMutator::setMutatorFunction(const std::function<void(geometrize::RotatedRectangle&)>& f)
 {
     m_mutateRotatedRectangle = f;
+    m_defaultMutateRotatedRectangle = false;
 }
 
 void ShapeMutator::setup(geometrize::Triangle& shape) const
@@ -543,6 +749,17 @@ void ShapeMutator::mutate(geometrize::Triangle& shape) const
     m_mutateTriangle(shape);
 }
 
+void ShapeMutator::mutate(geometrize::Triangle& shape, geometrize::ShapeUndo& undo) const
+{
+    if(m_defaultMutateTriangle) {
+        undo.begin();
+        mutateAndRecord(shape, undo);
+    } else {
+        undo.beginUnrecorded();
+        m_mutateTriangle(shape);
+    }
+}
+
 void ShapeMutator::setSetupFunction(const std::function<void(geometrize::Triangle&)>& f)
 {
     m_setupTriangle = f;
@@ -551,6 +768,7 @@ void ShapeMutator::setSetupFunction(const std::function<void(geometrize::Triangl
 void ShapeMutator::setMutatorFunction(const std::function<void(geometrize::Triangle&)>& f)
 {
     m_mutateTriangle = f;
+    m_defaultMutateTriangle = false;
 }
 
 }
@@ -12,6 +12,7 @@ class QuadraticBezier;
 class Rectangle;
 class RotatedEllipse;
 class RotatedRectangle;
+class ShapeUndo;
 class Triangle;
 }
 
@@ -59,46 +60,55 @@ public:
 
     void setup(geometrize::Circle& shape) const;
     void mutate(geometrize::Circle& shape) const;
+    void mutate(geometrize::Circle& shape, geometrize::ShapeUndo& undo) const;
     void setSetupFunction(const std::function<void(geometrize::Circle&)>& f);
     void setMutatorFunction(const std::function<void(geometrize::Circle&)>& f);
 
     void setup(geometrize::Ellipse& shape) const;
     void mutate(geometrize::Ellipse& shape) const;
+    void mutate(geometrize::Ellipse& shape, geometrize::ShapeUndo& undo) const;
     void setSetupFunction(const std::function<void(geometrize::Ellipse&)>& f);
     void setMutatorFunction(const std::function<void(geometrize::Ellipse&)>& f);
 
     void setup(geometrize::Line& shape) const;
     void mutate(geometrize::Line& shape) const;
+    void mutate(geometrize::Line& shape, geometrize::ShapeUndo& undo) const;
     void setSetupFunction(const std::function<void(geometrize::Line&)>& f);
     void setMutatorFunction(const std::function<void(geometrize::Line&)>& f);
 
     void setup(geometrize::Polyline& shape) const;
     void mutate(geometrize::Polyline& shape) const;
+    void mutate(geometrize::Polyline& shape, geometrize::ShapeUndo& undo) const;
     void setSetupFunction(const std::function<void(geometrize::Polyline&)>& f);
     void setMutatorFunction(const std::function<void(geometrize::Polyline&)>& f);
 
     void setup(geometrize::QuadraticBezier& shape) const;
     void mutate(geometrize::QuadraticBezier& shape) const;
+    void mutate(geometrize::QuadraticBezier& shape, geometrize::ShapeUndo& undo) const;
     void setSetupFunction(const std::function<void(geometrize::QuadraticBezier&)>& f);
     void setMutatorFunction(const std::function<void(geometrize::QuadraticBezier&)>& f);
 
     void setup(geometrize::Rectangle& shape) const;
     void mutate(geometrize::Rectangle& shape) const;
+    void mutate(geometrize::Rectangle& shape, geometrize::ShapeUndo& undo) const;
     void setSetupFunction(const std::function<void(geometrize::Rectangle&)>& f);
     void setMutatorFunction(const std::function<void(geometrize::Rectangle&)>& f);
 
     void setup(geometrize::RotatedEllipse& shape) const;
     void mutate(geometrize::RotatedEllipse& shape) const;
+    void mutate(geometrize::RotatedEllipse& shape, geometrize::ShapeUndo& undo) const;
     void setSetupFunction(const std::function<void(geometrize::RotatedEllipse&)>& f);
     void setMutatorFunction(const std::function<void(geometrize::RotatedEllipse&)>& f);
 
     void setup(geometrize::RotatedRectangle& shape) const;
     void mutate(geometrize::RotatedRectangle& shape) const;
+    void mutate(geometrize::RotatedRectangle& shape, geometrize::ShapeUndo& undo) const;
     void setSetupFunction(const std::function<void(geometrize::RotatedRectangle&)>& f);
     void setMutatorFunction(const std::function<void(geometrize::RotatedRectangle&)>& f);
 
     void setup(geometrize::Triangle& shape) const;
     void mutate(geometrize::Triangle& shape) const;
+    void mutate(geometrize::Triangle& shape, geometrize::ShapeUndo& undo) const;
     void setSetupFunction(const std::function<void(geometrize::Triangle&)>& f);
     void setMutatorFunction(const std::function<void(geometrize::Triangle&)>& f);
 
@@ -122,6 +132,16 @@ private:
     std::function<void(geometrize::RotatedEllipse&)> m_mutateRotatedEllipse;
     std::function<void(geometrize::RotatedRectangle&)> m_mutateRotatedRectangle;
     std::function<void(geometrize::Triangle&)> m_mutateTriangle;
+
+    bool m_defaultMutateCircle; ///< Whether the Circle mutator is the default one, which records its changes for undoing.
+    bool m_defaultMutateEllipse; ///< Whether the Ellipse mutator is the default one, which records its changes for undoing.
+    bool m_defaultMutateLine; ///< Whether the Line mutator is the default one, which records its changes for undoing.
+    bool m_defaultMutatePolyline; ///< Whether the Polyline mutator is the default one, which records its changes for undoing.
+    bool m_defaultMutateQuadraticBezier; ///< Whether the QuadraticBezier mutator is the default one, which records its changes for undoing.
+    bool m_defaultMutateRectangle; ///< Whether the Rectangle mutator is the default one, which records its changes for undoing.
+    bool m_defaultMutateRotatedEllipse; ///< Whether the RotatedEllipse mutator is the default one, which records its changes for undoing.
+    bool m_defaultMutateRotatedRectangle; ///< Whether the RotatedRectangle mutator is the default one, which records its changes for undoing.
+    bool m_defaultMutateTriangle; ///< Whether the Triangle mutator is the default one, which records its changes for undoing.
 };
 
 }
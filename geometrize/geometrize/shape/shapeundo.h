@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+namespace geometrize
+{
+
+/**
+ * @brief The ShapeUndo class records which parameters of a shape a mutation changed and what their old values were, so the mutation can be reverted without copying the shape.
+ * Only the default mutators record their changes. When a shape is mutated by a custom mutator function, the record is marked incomplete and the caller must restore a copy of the shape instead.
+ * @author Sam Twidale (http://samcodes.co.uk/)
+ */
+class ShapeUndo
+{
+public:
+    ShapeUndo() : m_count{0}, m_complete{false} {}
+
+    /**
+     * @brief begin Clears the record, ready for a mutation that records its changes.
+     */
+    void begin()
+    {
+        m_count = 0;
+        m_complete = true;
+    }
+
+    /**
+     * @brief beginUnrecorded Clears the record and marks it incomplete, for a mutation that will not record its changes.
+     */
+    void beginUnrecorded()
+    {
+        m_count = 0;
+        m_complete = false;
+    }
+
+    /**
+     * @brief record Records the old value of a parameter that is about to be changed. The parameter must outlive the record.
+     * @param field The parameter that is about to be changed.
+     */
+    void record(std::int32_t& field)
+    {
+        assert(m_count < maxFields && "Too many parameters changed for the undo record");
+        m_fields[m_count] = &field;
+        m_values[m_count] = field;
+        m_count++;
+    }
+
+    /**
+     * @brief isComplete Gets whether the record holds every change made by the last mutation, so it can be reverted.
+     * @return True if the mutation can be reverted using this record, else false.
+     */
+    bool isComplete() const
+    {
+        return m_complete;
+    }
+
+    /**
+     * @brief revert Restores the recorded parameters to their old values, in reverse order. The record must be complete.
+     */
+    void revert()
+    {
+        assert(m_complete && "Cannot revert a mutation that did not record its changes");
+        for(std::size_t i = m_count; i > 0; i--) {
+            *m_fields[i - 1U] = m_values[i - 1U];
+        }
+        m_count = 0;
+    }
+
+private:
+    static const std::size_t maxFields{4}; ///< The maximum number of parameters a single mutation can change.
+
+    std::int32_t* m_fields[maxFields]; ///< The parameters that were changed.
+    std::int32_t m_values[maxFields]; ///< The old values of the parameters that were changed.
+    std::size_t m_count; ///< The number of parameters recorded.
+    bool m_complete; ///< Whether every change made by the mutation was recorded.
+};
+
+}
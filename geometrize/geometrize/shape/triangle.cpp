@@ -1,5 +1,6 @@
 #include "triangle.h"
 
+#include <cassert>
 #include <cstdint>
 #include <memory>
 #include <sstream>
@@ -20,20 +21,28 @@ Triangle::Triangle(const geometrize::Model& model) : Shape{model}
 
 std::shared_ptr<geometrize::Shape> Triangle::clone() const
 {
-    std::shared_ptr<geometrize::Triangle> triangle{std::make_shared<geometrize::Triangle>(m_model)};
-    triangle->m_x1 = m_x1;
-    triangle->m_y1 = m_y1;
-    triangle->m_x2 = m_x2;
-    triangle->m_y2 = m_y2;
-    triangle->m_x3 = m_x3;
-    triangle->m_y3 = m_y3;
-    return triangle;
+    return std::make_shared<geometrize::Triangle>(*this);
+}
+
+bool Triangle::assign(const geometrize::Shape& other)
+{
+    assert(other.getType() == getType());
+    *this = static_cast<const geometrize::Triangle&>(other);
+    return true;
 }
 
 std::vector<geometrize::Scanline> Triangle::rasterize() const
 {
-    std::vector<geometrize::Scanline> scanlines{geometrize::scanlinesForPolygon({{m_x1, m_y1}, {m_x2, m_y2}, {m_x3, m_y3}})};
-    return Scanline::trim(scanlines, m_model.getWidth(), m_model.getHeight());
+    std::vector<geometrize::Scanline> lines;
+    rasterize(lines);
+    return lines;
+}
+
+void Triangle::rasterize(std::vector<geometrize::Scanline>& lines) const
+{
+    const std::pair<std::int32_t, std::int32_t> points[3]{{m_x1, m_y1}, {m_x2, m_y2}, {m_x3, m_y3}};
+    geometrize::scanlinesForPolygon(points, 3U, lines);
+    geometrize::Scanline::trimInPlace(lines, m_model.getWidth(), m_model.getHeight());
 }
 
 void Triangle::mutate()
@@ -41,6 +50,11 @@ void Triangle::mutate()
     m_model.mutateShape(*this);
 }
 
+void Triangle::mutate(geometrize::ShapeUndo& undo)
+{
+    m_model.mutateShape(*this, undo);
+}
+
 geometrize::ShapeTypes Triangle::getType() const
 {
     return ShapeTypes::TRIANGLE;
@@ -0,0 +1,687 @@
+#include "spankernels.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define GEOMETRIZE_X86_SPAN_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace
+{
+
+// Scalar versions
+
+void sumChannelsScalar(const std::uint8_t* pixels, const std::size_t count, std::uint64_t (&totals)[4])
+{
+    std::uint64_t r{0};
+    std::uint64_t g{0};
+    std::uint64_t b{0};
+    std::uint64_t a{0};
+    for(std::size_t i = 0; i < count; i++) {
+        r += pixels[i * 4U];
+        g += pixels[i * 4U + 1U];
+        b += pixels[i * 4U + 2U];
+        a += pixels[i * 4U + 3U];
+    }
+    totals[0] += r;
+    totals[1] += g;
+    totals[2] += b;
+    totals[3] += a;
+}
+
+std::int64_t differenceScalar(const std::uint8_t* target, const std::uint8_t* before, const std::uint8_t* after, const std::size_t count)
+{
+    std::int64_t total{0};
+    for(std::size_t i = 0; i < count * 4U; i++) {
+        const std::int32_t t{target[i]};
+        const std::int32_t dtb{t - static_cast<std::int32_t>(before[i])};
+        const std::int32_t dta{t - static_cast<std::int32_t>(after[i])};
+        total += dta * dta - dtb * dtb;
+    }
+    return total;
+}
+
+std::uint64_t squaredDifferenceScalar(const std::uint8_t* first, const std::uint8_t* second, const std::size_t count)
+{
+    std::uint64_t total{0};
+    for(std::size_t i = 0; i < count * 4U; i++) {
+        const std::int32_t d{static_cast<std::int32_t>(first[i]) - static_cast<std::int32_t>(second[i])};
+        total += static_cast<std::uint64_t>(d * d);
+    }
+    return total;
+}
+
+inline std::int32_t blendChannelScalar(const std::int32_t b, const geometrize::kernels::BlendConstants& blend, const std::size_t channel)
+{
+    return (b * blend.inverseAlpha + blend.offsets[channel]) / 65280;
+}
+
+std::int64_t differenceBlendedScalar(const std::uint8_t* target, const std::uint8_t* before, const std::size_t count, const geometrize::kernels::BlendConstants& blend)
+{
+    std::int64_t total{0};
+    if(blend.opaque) {
+        // The alpha channel of opaque pixels is left at 255 by the blend, so it adds nothing to the change in error
+        for(std::size_t i = 0; i < count * 4U; i += 4U) {
+            for(std::size_t c = 0; c < 3U; c++) {
+                const std::int32_t t{target[i + c]};
+                const std::int32_t b{before[i + c]};
+                const std::int32_t n{blendChannelScalar(b, blend, c)};
+                total += (t - n) * (t - n) - (t - b) * (t - b);
+            }
+        }
+        return total;
+    }
+    for(std::size_t i = 0; i < count * 4U; i++) {
+        const std::int32_t t{target[i]};
+        const std::int32_t b{before[i]};
+        const std::int32_t n{blendChannelScalar(b, blend, i & 3U)};
+        total += (t - n) * (t - n) - (t - b) * (t - b);
+    }
+    return total;
+}
+
+void blendScalar(std::uint8_t* pixels, const std::size_t count, const geometrize::kernels::BlendConstants& blend)
+{
+    if(blend.opaque) {
+        for(std::size_t i = 0; i < count * 4U; i += 4U) {
+            for(std::size_t c = 0; c < 3U; c++) {
+                pixels[i + c] = static_cast<std::uint8_t>(blendChannelScalar(pixels[i + c], blend, c));
+            }
+        }
+        return;
+    }
+    for(std::size_t i = 0; i < count * 4U; i++) {
+        pixels[i] = static_cast<std::uint8_t>(blendChannelScalar(pixels[i], blend, i & 3U));
+    }
+}
+
+#ifdef GEOMETRIZE_X86_SPAN_KERNELS
+
+// The blended channel value n = (b * inverseAlpha + offset) / 65280 is worked out in 16-bit lanes. With p = b * inverseAlpha8 and s = p + premultiplied,
+// which both fit in 16 bits, the dividend is 255 * s + 2 * p. Splitting s into its high byte h and low byte l gives n = h + (255 * l + 2 * p) / 65280,
+// and the second term is 0, 1 or 2 depending on whether p reaches the thresholds k1 = (65281 - 255 * l) / 2 and k1 + 32640.
+// The squared error change (t - n)^2 - (t - b)^2 is calculated as (b - n) * (2t - b - n), which fits in a 32-bit product of 16-bit lanes.
+// Each lane of the 32-bit accumulators grows by at most 65025 per channel, so they are added to the 64-bit total every 8192 pixels.
+const std::size_t flushInterval{8192};
+
+__attribute__((target("sse4.1")))
+inline std::int64_t horizontalSum(const __m128i v)
+{
+    return static_cast<std::int64_t>(_mm_extract_epi32(v, 0)) + _mm_extract_epi32(v, 1) + _mm_extract_epi32(v, 2) + _mm_extract_epi32(v, 3);
+}
+
+__attribute__((target("sse4.1")))
+void sumChannelsSse41(const std::uint8_t* pixels, const std::size_t count, std::uint64_t (&totals)[4])
+{
+    const __m128i zero{_mm_setzero_si128()};
+    std::size_t i{0};
+    while(i + 4U <= count) {
+        // 16-bit lanes take 2 pixels per iteration, so can take 128 iterations before overflowing
+        const std::size_t blockEnd{(count - i) / 4U > 128U ? i + 512U : count};
+        __m128i sums{zero};
+        for(; i + 4U <= blockEnd; i += 4U) {
+            const __m128i v{_mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + i * 4U))};
+            sums = _mm_add_epi16(sums, _mm_add_epi16(_mm_unpacklo_epi8(v, zero), _mm_unpackhi_epi8(v, zero)));
+        }
+        const __m128i wide{_mm_add_epi32(_mm_unpacklo_epi16(sums, zero), _mm_unpackhi_epi16(sums, zero))};
+        totals[0] += static_cast<std::uint32_t>(_mm_extract_epi32(wide, 0));
+        totals[1] += static_cast<std::uint32_t>(_mm_extract_epi32(wide, 1));
+        totals[2] += static_cast<std::uint32_t>(_mm_extract_epi32(wide, 2));
+        totals[3] += static_cast<std::uint32_t>(_mm_extract_epi32(wide, 3));
+    }
+    sumChannelsScalar(pixels + i * 4U, count - i, totals);
+}
+
+__attribute__((target("sse4.1")))
+std::int64_t differenceSse41(const std::uint8_t* target, const std::uint8_t* before, const std::uint8_t* after, const std::size_t count)
+{
+    const __m128i zero{_mm_setzero_si128()};
+    std::int64_t total{0};
+    std::size_t i{0};
+    while(i + 4U <= count) {
+        // Each 32-bit lane takes the change for four channels per iteration
+        const std::size_t blockEnd{(count - i) / 4U > flushInterval / 4U ? i + flushInterval : count};
+        __m128i sums{zero};
+        for(; i + 4U <= blockEnd; i += 4U) {
+            const __m128i t{_mm_loadu_si128(reinterpret_cast<const __m128i*>(target + i * 4U))};
+            const __m128i b{_mm_loadu_si128(reinterpret_cast<const __m128i*>(before + i * 4U))};
+            const __m128i a{_mm_loadu_si128(reinterpret_cast<const __m128i*>(after + i * 4U))};
+            const __m128i tlo{_mm_unpacklo_epi8(t, zero)};
+            const __m128i thi{_mm_unpackhi_epi8(t, zero)};
+            const __m128i dtblo{_mm_sub_epi16(tlo, _mm_unpacklo_epi8(b, zero))};
+            const __m128i dtbhi{_mm_sub_epi16(thi, _mm_unpackhi_epi8(b, zero))};
+            const __m128i dtalo{_mm_sub_epi16(tlo, _mm_unpacklo_epi8(a, zero))};
+            const __m128i dtahi{_mm_sub_epi16(thi, _mm_unpackhi_epi8(a, zero))};
+            sums = _mm_add_epi32(sums, _mm_sub_epi32(_mm_madd_epi16(dtalo, dtalo), _mm_madd_epi16(dtblo, dtblo)));
+            sums = _mm_add_epi32(sums, _mm_sub_epi32(_mm_madd_epi16(dtahi, dtahi), _mm_madd_epi16(dtbhi, dtbhi)));
+        }
+        total += horizontalSum(sums);
+    }
+    return total + differenceScalar(target + i * 4U, before + i * 4U, after + i * 4U, count - i);
+}
+
+__attribute__((target("sse4.1")))
+std::uint64_t squaredDifferenceSse41(const std::uint8_t* first, const std::uint8_t* second, const std::size_t count)
+{
+    const __m128i zero{_mm_setzero_si128()};
+    std::uint64_t total{0};
+    std::size_t i{0};
+    while(i + 4U <= count) {
+        // Each 32-bit lane takes the squares for four channels per iteration
+        const std::size_t blockEnd{(count - i) / 4U > flushInterval / 4U ? i + flushInterval : count};
+        __m128i sums{zero};
+        for(; i + 4U <= blockEnd; i += 4U) {
+            const __m128i f{_mm_loadu_si128(reinterpret_cast<const __m128i*>(first + i * 4U))};
+            const __m128i s{_mm_loadu_si128(reinterpret_cast<const __m128i*>(second + i * 4U))};
+            const __m128i dlo{_mm_sub_epi16(_mm_unpacklo_epi8(f, zero), _mm_unpacklo_epi8(s, zero))};
+            const __m128i dhi{_mm_sub_epi16(_mm_unpackhi_epi8(f, zero), _mm_unpackhi_epi8(s, zero))};
+            sums = _mm_add_epi32(sums, _mm_add_epi32(_mm_madd_epi16(dlo, dlo), _mm_madd_epi16(dhi, dhi)));
+        }
+        total += static_cast<std::uint64_t>(horizontalSum(sums));
+    }
+    return total + squaredDifferenceScalar(first + i * 4U, second + i * 4U, count - i);
+}
+
+// The last one to three pixels of a span are loaded and stored as a group of two and a single pixel, with the rest of the register zeroed
+__attribute__((target("sse4.1")))
+inline __m128i loadTail(const std::uint8_t* pixels, const std::size_t count)
+{
+    std::int32_t last;
+    std::memcpy(&last, pixels + (count - 1U) * 4U, sizeof(last));
+    if(count == 1U) {
+        return _mm_cvtsi32_si128(last);
+    }
+    const __m128i pair{_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pixels))};
+    return count == 2U ? pair : _mm_insert_epi32(pair, last, 2);
+}
+
+__attribute__((target("sse4.1")))
+inline void storeTail(std::uint8_t* pixels, const std::size_t count, const __m128i v)
+{
+    if(count >= 2U) {
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(pixels), v);
+    }
+    if(count != 2U) {
+        const std::int32_t last{count == 1U ? _mm_cvtsi128_si32(v) : _mm_extract_epi32(v, 2)};
+        std::memcpy(pixels + (count - 1U) * 4U, &last, sizeof(last));
+    }
+}
+
+__attribute__((target("sse4.1")))
+inline __m128i tailMaskSse41(const std::size_t count)
+{
+    return _mm_cmpgt_epi32(_mm_set1_epi32(static_cast<std::int32_t>(count)), _mm_setr_epi32(0, 1, 2, 3));
+}
+
+/**
+ * @brief The BlendLanesSse41 struct holds the blend constants spread across 16-bit lanes, for two pixels per register.
+ */
+struct BlendLanesSse41
+{
+    __attribute__((target("sse4.1")))
+    explicit BlendLanesSse41(const geometrize::kernels::BlendConstants& blend) :
+        inverseAlpha{_mm_set1_epi16(static_cast<std::int16_t>(blend.inverseAlpha8))},
+        premultiplied{_mm_setr_epi16(
+            static_cast<std::int16_t>(blend.premultiplied[0]), static_cast<std::int16_t>(blend.premultiplied[1]), static_cast<std::int16_t>(blend.premultiplied[2]), static_cast<std::int16_t>(blend.premultiplied[3]),
+            static_cast<std::int16_t>(blend.premultiplied[0]), static_cast<std::int16_t>(blend.premultiplied[1]), static_cast<std::int16_t>(blend.premultiplied[2]), static_cast<std::int16_t>(blend.premultiplied[3]))},
+        lowByte{_mm_set1_epi16(0xFF)},
+        threshold{_mm_set1_epi16(static_cast<std::int16_t>(65281U))},
+        secondThreshold{_mm_set1_epi16(32640)}
+    {}
+
+    __m128i inverseAlpha;
+    __m128i premultiplied;
+    __m128i lowByte;
+    __m128i threshold;
+    __m128i secondThreshold;
+};
+
+__attribute__((target("sse4.1")))
+inline __m128i blendChannelsSse41(const __m128i b, const BlendLanesSse41& lanes)
+{
+    const __m128i p{_mm_mullo_epi16(b, lanes.inverseAlpha)};
+    const __m128i s{_mm_add_epi16(p, lanes.premultiplied)};
+    const __m128i l{_mm_and_si128(s, lanes.lowByte)};
+    const __m128i k1{_mm_srli_epi16(_mm_sub_epi16(lanes.threshold, _mm_sub_epi16(_mm_slli_epi16(l, 8), l)), 1)};
+    const __m128i k2{_mm_add_epi16(k1, lanes.secondThreshold)};
+    const __m128i reachesK1{_mm_cmpeq_epi16(_mm_max_epu16(p, k1), p)};
+    const __m128i reachesK2{_mm_cmpeq_epi16(_mm_max_epu16(p, k2), p)};
+    return _mm_sub_epi16(_mm_sub_epi16(_mm_srli_epi16(s, 8), reachesK1), reachesK2);
+}
+
+__attribute__((target("sse4.1")))
+inline __m128i differenceBlendedChannelsSse41(const __m128i t, const __m128i b, const BlendLanesSse41& lanes)
+{
+    const __m128i n{blendChannelsSse41(b, lanes)};
+    return _mm_madd_epi16(_mm_sub_epi16(b, n), _mm_sub_epi16(_mm_sub_epi16(_mm_add_epi16(t, t), b), n));
+}
+
+__attribute__((target("sse4.1")))
+void blendSse41(std::uint8_t* pixels, const std::size_t count, const geometrize::kernels::BlendConstants& blend)
+{
+    const BlendLanesSse41 lanes(blend);
+    const __m128i zero{_mm_setzero_si128()};
+
+    std::size_t i{0};
+    for(; i + 4U <= count; i += 4U) {
+        const __m128i v{_mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + i * 4U))};
+        const __m128i lo{blendChannelsSse41(_mm_unpacklo_epi8(v, zero), lanes)};
+        const __m128i hi{blendChannelsSse41(_mm_unpackhi_epi8(v, zero), lanes)};
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels + i * 4U), _mm_packus_epi16(lo, hi));
+    }
+    if(i < count) {
+        const __m128i v{loadTail(pixels + i * 4U, count - i)};
+        const __m128i lo{blendChannelsSse41(_mm_unpacklo_epi8(v, zero), lanes)};
+        const __m128i hi{blendChannelsSse41(_mm_unpackhi_epi8(v, zero), lanes)};
+        storeTail(pixels + i * 4U, count - i, _mm_packus_epi16(lo, hi));
+    }
+}
+
+__attribute__((target("sse4.1")))
+std::int64_t differenceBlendedSse41(const std::uint8_t* target, const std::uint8_t* before, const std::size_t count, const geometrize::kernels::BlendConstants& blend)
+{
+    const BlendLanesSse41 lanes(blend);
+    const __m128i zero{_mm_setzero_si128()};
+
+    std::int64_t total{0};
+    std::size_t i{0};
+    while(i + 4U <= count) {
+        const std::size_t blockEnd{count - i > flushInterval ? i + flushInterval : count};
+        __m128i sums{zero};
+        for(; i + 4U <= blockEnd; i += 4U) {
+            const __m128i t{_mm_loadu_si128(reinterpret_cast<const __m128i*>(target + i * 4U))};
+            const __m128i b{_mm_loadu_si128(reinterpret_cast<const __m128i*>(before + i * 4U))};
+            sums = _mm_add_epi32(sums, differenceBlendedChannelsSse41(_mm_unpacklo_epi8(t, zero), _mm_unpacklo_epi8(b, zero), lanes));
+            sums = _mm_add_epi32(sums, differenceBlendedChannelsSse41(_mm_unpackhi_epi8(t, zero), _mm_unpackhi_epi8(b, zero), lanes));
+        }
+        total += horizontalSum(sums);
+    }
+    if(i < count) {
+        // The pixels past the end load as zero, so their differences are masked out
+        const __m128i mask{tailMaskSse41(count - i)};
+        const __m128i t{loadTail(target + i * 4U, count - i)};
+        const __m128i b{loadTail(before + i * 4U, count - i)};
+        const __m128i lo{differenceBlendedChannelsSse41(_mm_unpacklo_epi8(t, zero), _mm_unpacklo_epi8(b, zero), lanes)};
+        const __m128i hi{differenceBlendedChannelsSse41(_mm_unpackhi_epi8(t, zero), _mm_unpackhi_epi8(b, zero), lanes)};
+        total += horizontalSum(_mm_add_epi32(
+            _mm_and_si128(lo, _mm_unpacklo_epi32(mask, mask)),
+            _mm_and_si128(hi, _mm_unpackhi_epi32(mask, mask))));
+    }
+    return total;
+}
+
+__attribute__((target("avx2")))
+inline std::int64_t horizontalSum(const __m256i v)
+{
+    const __m128i sum{_mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1))};
+    return static_cast<std::int64_t>(_mm_extract_epi32(sum, 0)) + _mm_extract_epi32(sum, 1) + _mm_extract_epi32(sum, 2) + _mm_extract_epi32(sum, 3);
+}
+
+__attribute__((target("avx2")))
+void sumChannelsAvx2(const std::uint8_t* pixels, const std::size_t count, std::uint64_t (&totals)[4])
+{
+    const __m256i zero{_mm256_setzero_si256()};
+    std::size_t i{0};
+    while(i + 8U <= count) {
+        // 16-bit lanes take 2 pixels per iteration, so can take 128 iterations before overflowing
+        const std::size_t blockEnd{(count - i) / 8U > 128U ? i + 1024U : count};
+        __m256i sums{zero};
+        for(; i + 8U <= blockEnd; i += 8U) {
+            const __m256i v{_mm256_loadu_si256(reinterpret_cast<const __m256i*>(pixels + i * 4U))};
+            sums = _mm256_add_epi16(sums, _mm256_add_epi16(_mm256_unpacklo_epi8(v, zero), _mm256_unpackhi_epi8(v, zero)));
+        }
+        const __m256i wide{_mm256_add_epi32(_mm256_unpacklo_epi16(sums, zero), _mm256_unpackhi_epi16(sums, zero))};
+        const __m128i folded{_mm_add_epi32(_mm256_castsi256_si128(wide), _mm256_extracti128_si256(wide, 1))};
+        totals[0] += static_cast<std::uint32_t>(_mm_extract_epi32(folded, 0));
+        totals[1] += static_cast<std::uint32_t>(_mm_extract_epi32(folded, 1));
+        totals[2] += static_cast<std::uint32_t>(_mm_extract_epi32(folded, 2));
+        totals[3] += static_cast<std::uint32_t>(_mm_extract_epi32(folded, 3));
+    }
+    // The compiler does not clear the upper halves of the registers before tail calls, and the scalar version may use SSE, which would stall on the switch
+    _mm256_zeroupper();
+    sumChannelsScalar(pixels + i * 4U, count - i, totals);
+}
+
+__attribute__((target("avx2")))
+std::int64_t differenceAvx2(const std::uint8_t* target, const std::uint8_t* before, const std::uint8_t* after, const std::size_t count)
+{
+    const __m256i zero{_mm256_setzero_si256()};
+    std::int64_t total{0};
+    std::size_t i{0};
+    while(i + 8U <= count) {
+        // Each 32-bit lane takes the change for four channels per iteration
+        const std::size_t blockEnd{(count - i) / 8U > flushInterval / 8U ? i + flushInterval : count};
+        __m256i sums{zero};
+        for(; i + 8U <= blockEnd; i += 8U) {
+            const __m256i t{_mm256_loadu_si256(reinterpret_cast<const __m256i*>(target + i * 4U))};
+            const __m256i b{_mm256_loadu_si256(reinterpret_cast<const __m256i*>(before + i * 4U))};
+            const __m256i a{_mm256_loadu_si256(reinterpret_cast<const __m256i*>(after + i * 4U))};
+            const __m256i tlo{_mm256_unpacklo_epi8(t, zero)};
+            const __m256i thi{_mm256_unpackhi_epi8(t, zero)};
+            const __m256i dtblo{_mm256_sub_epi16(tlo, _mm256_unpacklo_epi8(b, zero))};
+            const __m256i dtbhi{_mm256_sub_epi16(thi, _mm256_unpackhi_epi8(b, zero))};
+            const __m256i dtalo{_mm256_sub_epi16(tlo, _mm256_unpacklo_epi8(a, zero))};
+            const __m256i dtahi{_mm256_sub_epi16(thi, _mm256_unpackhi_epi8(a, zero))};
+            sums = _mm256_add_epi32(sums, _mm256_sub_epi32(_mm256_madd_epi16(dtalo, dtalo), _mm256_madd_epi16(dtblo, dtblo)));
+            sums = _mm256_add_epi32(sums, _mm256_sub_epi32(_mm256_madd_epi16(dtahi, dtahi), _mm256_madd_epi16(dtbhi, dtbhi)));
+        }
+        total += horizontalSum(sums);
+    }
+    return total + differenceScalar(target + i * 4U, before + i * 4U, after + i * 4U, count - i);
+}
+
+__attribute__((target("avx2")))
+std::uint64_t squaredDifferenceAvx2(const std::uint8_t* first, const std::uint8_t* second, const std::size_t count)
+{
+    const __m256i zero{_mm256_setzero_si256()};
+    std::uint64_t total{0};
+    std::size_t i{0};
+    while(i + 8U <= count) {
+        // Each 32-bit lane takes the squares for four channels per iteration
+        const std::size_t blockEnd{(count - i) / 8U > flushInterval / 8U ? i + flushInterval : count};
+        __m256i sums{zero};
+        for(; i + 8U <= blockEnd; i += 8U) {
+            const __m256i f{_mm256_loadu_si256(reinterpret_cast<const __m256i*>(first + i * 4U))};
+            const __m256i s{_mm256_loadu_si256(reinterpret_cast<const __m256i*>(second + i * 4U))};
+            const __m256i dlo{_mm256_sub_epi16(_mm256_unpacklo_epi8(f, zero), _mm256_unpacklo_epi8(s, zero))};
+            const __m256i dhi{_mm256_sub_epi16(_mm256_unpackhi_epi8(f, zero), _mm256_unpackhi_epi8(s, zero))};
+            sums = _mm256_add_epi32(sums, _mm256_add_epi32(_mm256_madd_epi16(dlo, dlo), _mm256_madd_epi16(dhi, dhi)));
+        }
+        total += static_cast<std::uint64_t>(horizontalSum(sums));
+    }
+    return total + squaredDifferenceScalar(first + i * 4U, second + i * 4U, count - i);
+}
+
+__attribute__((target("avx2")))
+inline __m256i tailMaskAvx2(const std::size_t count)
+{
+    return _mm256_cmpgt_epi32(_mm256_set1_epi32(static_cast<std::int32_t>(count)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+}
+
+/**
+ * @brief The BlendLanesAvx2 struct holds the blend constants spread across 16-bit lanes, for four pixels per register.
+ */
+struct BlendLanesAvx2
+{
+    __attribute__((target("avx2")))
+    explicit BlendLanesAvx2(const geometrize::kernels::BlendConstants& blend) :
+        inverseAlpha{_mm256_set1_epi16(static_cast<std::int16_t>(blend.inverseAlpha8))},
+        premultiplied{_mm256_set1_epi64x(static_cast<std::int64_t>(
+            static_cast<std::uint64_t>(blend.premultiplied[0]) | (static_cast<std::uint64_t>(blend.premultiplied[1]) << 16) |
+            (static_cast<std::uint64_t>(blend.premultiplied[2]) << 32) | (static_cast<std::uint64_t>(blend.premultiplied[3]) << 48)))},
+        lowByte{_mm256_set1_epi16(0xFF)},
+        threshold{_mm256_set1_epi16(static_cast<std::int16_t>(65281U))},
+        secondThreshold{_mm256_set1_epi16(32640)}
+    {}
+
+    __m256i inverseAlpha;
+    __m256i premultiplied;
+    __m256i lowByte;
+    __m256i threshold;
+    __m256i secondThreshold;
+};
+
+__attribute__((target("avx2")))
+inline __m256i blendChannelsAvx2(const __m256i b, const BlendLanesAvx2& lanes)
+{
+    const __m256i p{_mm256_mullo_epi16(b, lanes.inverseAlpha)};
+    const __m256i s{_mm256_add_epi16(p, lanes.premultiplied)};
+    const __m256i l{_mm256_and_si256(s, lanes.lowByte)};
+    const __m256i k1{_mm256_srli_epi16(_mm256_sub_epi16(lanes.threshold, _mm256_sub_epi16(_mm256_slli_epi16(l, 8), l)), 1)};
+    const __m256i k2{_mm256_add_epi16(k1, lanes.secondThreshold)};
+    const __m256i reachesK1{_mm256_cmpeq_epi16(_mm256_max_epu16(p, k1), p)};
+    const __m256i reachesK2{_mm256_cmpeq_epi16(_mm256_max_epu16(p, k2), p)};
+    return _mm256_sub_epi16(_mm256_sub_epi16(_mm256_srli_epi16(s, 8), reachesK1), reachesK2);
+}
+
+__attribute__((target("avx2")))
+inline __m256i differenceBlendedChannelsAvx2(const __m256i t, const __m256i b, const BlendLanesAvx2& lanes)
+{
+    const __m256i n{blendChannelsAvx2(b, lanes)};
+    return _mm256_madd_epi16(_mm256_sub_epi16(b, n), _mm256_sub_epi16(_mm256_sub_epi16(_mm256_add_epi16(t, t), b), n));
+}
+
+__attribute__((target("avx2")))
+void blendAvx2(std::uint8_t* pixels, const std::size_t count, const geometrize::kernels::BlendConstants& blend)
+{
+    const BlendLanesAvx2 lanes(blend);
+    const __m256i zero{_mm256_setzero_si256()};
+
+    // Unpacking and packing both work within each 128-bit half, so the pixels stay in order
+    std::size_t i{0};
+    for(; i + 8U <= count; i += 8U) {
+        const __m256i v{_mm256_loadu_si256(reinterpret_cast<const __m256i*>(pixels + i * 4U))};
+        const __m256i lo{blendChannelsAvx2(_mm256_unpacklo_epi8(v, zero), lanes)};
+        const __m256i hi{blendChannelsAvx2(_mm256_unpackhi_epi8(v, zero), lanes)};
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(pixels + i * 4U), _mm256_packus_epi16(lo, hi));
+    }
+    if(i < count) {
+        const __m256i mask{tailMaskAvx2(count - i)};
+        int* tail{reinterpret_cast<int*>(pixels + i * 4U)};
+        const __m256i v{_mm256_maskload_epi32(tail, mask)};
+        const __m256i lo{blendChannelsAvx2(_mm256_unpacklo_epi8(v, zero), lanes)};
+        const __m256i hi{blendChannelsAvx2(_mm256_unpackhi_epi8(v, zero), lanes)};
+        _mm256_maskstore_epi32(tail, mask, _mm256_packus_epi16(lo, hi));
+    }
+}
+
+__attribute__((target("avx2")))
+std::int64_t differenceBlendedAvx2(const std::uint8_t* target, const std::uint8_t* before, const std::size_t count, const geometrize::kernels::BlendConstants& blend)
+{
+    const BlendLanesAvx2 lanes(blend);
+    const __m256i zero{_mm256_setzero_si256()};
+
+    std::int64_t total{0};
+    std::size_t i{0};
+    while(i + 8U <= count) {
+        const std::size_t blockEnd{count - i > flushInterval ? i + flushInterval : count};
+        __m256i sums{zero};
+        for(; i + 8U <= blockEnd; i += 8U) {
+            const __m256i t{_mm256_loadu_si256(reinterpret_cast<const __m256i*>(target + i * 4U))};
+            const __m256i b{_mm256_loadu_si256(reinterpret_cast<const __m256i*>(before + i * 4U))};
+            sums = _mm256_add_epi32(sums, differenceBlendedChannelsAvx2(_mm256_unpacklo_epi8(t, zero), _mm256_unpacklo_epi8(b, zero), lanes));
+            sums = _mm256_add_epi32(sums, differenceBlendedChannelsAvx2(_mm256_unpackhi_epi8(t, zero), _mm256_unpackhi_epi8(b, zero), lanes));
+        }
+        total += horizontalSum(sums);
+    }
+    if(i < count) {
+        // The pixels past the end load as zero, so their differences are masked out
+        const __m256i mask{tailMaskAvx2(count - i)};
+        const __m256i t{_mm256_maskload_epi32(reinterpret_cast<const int*>(target + i * 4U), mask)};
+        const __m256i b{_mm256_maskload_epi32(reinterpret_cast<const int*>(before + i * 4U), mask)};
+        const __m256i lo{differenceBlendedChannelsAvx2(_mm256_unpacklo_epi8(t, zero), _mm256_unpacklo_epi8(b, zero), lanes)};
+        const __m256i hi{differenceBlendedChannelsAvx2(_mm256_unpackhi_epi8(t, zero), _mm256_unpackhi_epi8(b, zero), lanes)};
+        total += horizontalSum(_mm256_add_epi32(
+            _mm256_and_si256(lo, _mm256_unpacklo_epi32(mask, mask)),
+            _mm256_and_si256(hi, _mm256_unpackhi_epi32(mask, mask))));
+    }
+    return total;
+}
+
+#endif
+
+/**
+ * @brief The Kernels struct is a table of one version of each of the span kernels.
+ */
+struct Kernels
+{
+    void (*sumChannels)(const std::uint8_t*, std::size_t, std::uint64_t (&)[4]);
+    std::uint64_t (*squaredDifference)(const std::uint8_t*, const std::uint8_t*, std::size_t);
+    std::int64_t (*difference)(const std::uint8_t*, const std::uint8_t*, const std::uint8_t*, std::size_t);
+    std::int64_t (*differenceBlended)(const std::uint8_t*, const std::uint8_t*, std::size_t, const geometrize::kernels::BlendConstants&);
+    void (*blend)(std::uint8_t*, std::size_t, const geometrize::kernels::BlendConstants&);
+};
+
+const Kernels kernelTables[]{
+    { sumChannelsScalar, squaredDifferenceScalar, differenceScalar, differenceBlendedScalar, blendScalar },
+#ifdef GEOMETRIZE_X86_SPAN_KERNELS
+    { sumChannelsSse41, squaredDifferenceSse41, differenceSse41, differenceBlendedSse41, blendSse41 },
+    { sumChannelsAvx2, squaredDifferenceAvx2, differenceAvx2, differenceBlendedAvx2, blendAvx2 },
+#endif
+};
+
+geometrize::kernels::InstructionSet detectInstructionSet()
+{
+#ifdef GEOMETRIZE_X86_SPAN_KERNELS
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2")) {
+        return geometrize::kernels::InstructionSet::AVX2;
+    }
+    if(__builtin_cpu_supports("sse4.1")) {
+        return geometrize::kernels::InstructionSet::SSE41;
+    }
+#endif
+    return geometrize::kernels::InstructionSet::SCALAR;
+}
+
+const geometrize::kernels::InstructionSet supportedInstructionSet{detectInstructionSet()};
+
+std::atomic<std::uint32_t> instructionSet{static_cast<std::uint32_t>(supportedInstructionSet)};
+
+const Kernels& getKernels()
+{
+    return kernelTables[instructionSet.load(std::memory_order_relaxed)];
+}
+
+}
+
+namespace geometrize
+{
+
+namespace kernels
+{
+
+InstructionSet getSupportedInstructionSet()
+{
+    return supportedInstructionSet;
+}
+
+InstructionSet getInstructionSet()
+{
+    return static_cast<InstructionSet>(instructionSet.load(std::memory_order_relaxed));
+}
+
+void setInstructionSet(const InstructionSet set)
+{
+    const InstructionSet supported{getSupportedInstructionSet()};
+    instructionSet.store(static_cast<std::uint32_t>(set > supported ? supported : set), std::memory_order_relaxed);
+}
+
+BlendConstants blendConstants(const std::uint8_t r, const std::uint8_t g, const std::uint8_t b, const std::uint8_t a)
+{
+    return blendConstants(r, g, b, a, false);
+}
+
+BlendConstants blendConstants(const std::uint8_t r, const std::uint8_t g, const std::uint8_t b, const std::uint8_t a, const bool opaque)
+{
+    // Equivalent to the blend in geometrize::drawLines, ((before * (65535 - sa) * 257 + s * 65535) / 65535) >> 8, with the common factor of 257 cancelled out
+    const std::int32_t sa{a * 257};
+    BlendConstants blend;
+    blend.inverseAlpha = 65535 - sa;
+    blend.offsets[0] = 255 * static_cast<std::int32_t>((r * 257U * a) / 255U);
+    blend.offsets[1] = 255 * static_cast<std::int32_t>((g * 257U * a) / 255U);
+    blend.offsets[2] = 255 * static_cast<std::int32_t>((b * 257U * a) / 255U);
+    blend.offsets[3] = 255 * sa;
+    blend.inverseAlpha8 = static_cast<std::uint16_t>(255U - a);
+    for(std::size_t i = 0; i < 4U; i++) {
+        blend.premultiplied[i] = static_cast<std::uint16_t>(blend.offsets[i] / 255);
+    }
+    blend.opaque = opaque;
+    return blend;
+}
+
+BlendConstants grayBlendConstants(const std::uint8_t gray, const std::uint8_t a)
+{
+    BlendConstants blend{blendConstants(gray, gray, gray, a)};
+    blend.offsets[3] = blend.offsets[0];
+    blend.premultiplied[3] = blend.premultiplied[0];
+    return blend;
+}
+
+void sumChannels(const std::uint8_t* pixels, const std::size_t count, std::uint64_t (&totals)[4])
+{
+    getKernels().sumChannels(pixels, count, totals);
+}
+
+std::uint64_t squaredDifference(const std::uint8_t* first, const std::uint8_t* second, const std::size_t count)
+{
+    return getKernels().squaredDifference(first, second, count);
+}
+
+std::int64_t difference(const std::uint8_t* target, const std::uint8_t* before, const std::uint8_t* after, const std::size_t count)
+{
+    return getKernels().difference(target, before, after, count);
+}
+
+std::int64_t differenceBlended(const std::uint8_t* target, const std::uint8_t* before, const std::size_t count, const BlendConstants& blend)
+{
+    return getKernels().differenceBlended(target, before, count, blend);
+}
+
+void blend(std::uint8_t* pixels, const std::size_t count, const BlendConstants& blend)
+{
+    getKernels().blend(pixels, count, blend);
+}
+
+// The grayscale kernels run the RGBA kernels on groups of four gray pixels, since they treat every byte alike, and finish the last few pixels here
+
+std::uint64_t sumGray(const std::uint8_t* pixels, const std::size_t count)
+{
+    std::uint64_t totals[4]{0, 0, 0, 0};
+    getKernels().sumChannels(pixels, count / 4U, totals);
+    std::uint64_t total{totals[0] + totals[1] + totals[2] + totals[3]};
+    for(std::size_t i = count & ~std::size_t{3U}; i < count; i++) {
+        total += pixels[i];
+    }
+    return total;
+}
+
+std::uint64_t squaredDifferenceGray(const std::uint8_t* first, const std::uint8_t* second, const std::size_t count)
+{
+    std::uint64_t total{getKernels().squaredDifference(first, second, count / 4U)};
+    for(std::size_t i = count & ~std::size_t{3U}; i < count; i++) {
+        const std::int32_t d{first[i] - second[i]};
+        total += static_cast<std::uint64_t>(d * d);
+    }
+    return total;
+}
+
+std::int64_t differenceGray(const std::uint8_t* target, const std::uint8_t* before, const std::uint8_t* after, const std::size_t count)
+{
+    std::int64_t total{getKernels().difference(target, before, after, count / 4U)};
+    for(std::size_t i = count & ~std::size_t{3U}; i < count; i++) {
+        const std::int32_t t{target[i]};
+        const std::int32_t b{before[i]};
+        const std::int32_t a{after[i]};
+        total += (t - a) * (t - a) - (t - b) * (t - b);
+    }
+    return total;
+}
+
+std::int64_t differenceBlendedGray(const std::uint8_t* target, const std::uint8_t* before, const std::size_t count, const BlendConstants& blend)
+{
+    std::int64_t total{getKernels().differenceBlended(target, before, count / 4U, blend)};
+    for(std::size_t i = count & ~std::size_t{3U}; i < count; i++) {
+        const std::int32_t t{target[i]};
+        const std::int32_t b{before[i]};
+        const std::int32_t n{blendChannelScalar(b, blend, 0U)};
+        total += (t - n) * (t - n) - (t - b) * (t - b);
+    }
+    return total;
+}
+
+void blendGray(std::uint8_t* pixels, const std::size_t count, const BlendConstants& blend)
+{
+    getKernels().blend(pixels, count / 4U, blend);
+    for(std::size_t i = count & ~std::size_t{3U}; i < count; i++) {
+        pixels[i] = static_cast<std::uint8_t>(blendChannelScalar(pixels[i], blend, 0U));
+    }
+}
+
+}
+
+}
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace geometrize
+{
+
+namespace kernels
+{
+
+/**
+ * The span kernels do the per-pixel work of the core functions on runs of RGBA8888 pixels, and the grayscale kernels do the same on runs of GRAY8 pixels.
+ * Each kernel has a scalar version and vectorized versions for x86 processors, and the best version the processor supports is detected with __builtin_cpu_supports and selected during static initialization, before main runs. setInstructionSet can override the choice later.
+ * All of the versions give exactly the same results.
+ * @author Sam Twidale (http://samcodes.co.uk/)
+ */
+
+/**
+ * @brief The InstructionSet enum specifies the versions of the span kernels.
+ */
+enum class InstructionSet : std::uint32_t
+{
+    SCALAR = 0U, ///< Plain C++, used on all processors.
+    SSE41 = 1U, ///< SSE4.1, works on 128-bit registers.
+    AVX2 = 2U ///< AVX2, works on 256-bit registers.
+};
+
+/**
+ * @brief The BlendConstants struct holds the constants that geometrize::drawLines blends a color with.
+ * A channel value b blended with the color becomes (b * inverseAlpha + offsets[channel]) / 65280, rounded down.
+ * Since inverseAlpha is 257 * inverseAlpha8 and offsets[channel] is 255 * premultiplied[channel], the vectorized kernels work out the same value in 16-bit arithmetic from the smaller constants.
+ */
+struct BlendConstants
+{
+    std::int32_t inverseAlpha; ///< 65535 minus the alpha of the color scaled to 16 bits.
+    std::int32_t offsets[4]; ///< 255 times the alpha-premultiplied color scaled to 16 bits, for each channel.
+    std::uint16_t inverseAlpha8; ///< 255 minus the alpha of the color.
+    std::uint16_t premultiplied[4]; ///< The alpha-premultiplied color scaled to 16 bits, for each channel.
+    bool opaque; ///< Whether the pixels blended are all opaque. Blending keeps them opaque, so the scalar kernels skip their alpha channel.
+};
+
+/**
+ * @brief getSupportedInstructionSet Gets the best version of the span kernels that the processor supports.
+ * @return The best supported version of the span kernels.
+ */
+InstructionSet getSupportedInstructionSet();
+
+/**
+ * @brief getInstructionSet Gets the version of the span kernels in use.
+ * @return The version of the span kernels in use.
+ */
+InstructionSet getInstructionSet();
+
+/**
+ * @brief setInstructionSet Sets the version of the span kernels to use, for instance to compare the vectorized versions with the scalar one.
+ * @param instructionSet The version of the span kernels to use. If the processor does not support it, the best version it does support is used instead.
+ */
+void setInstructionSet(InstructionSet instructionSet);
+
+/**
+ * @brief blendConstants Gets the constants for blending a color the way geometrize::drawLines does.
+ * @param r The red component of the color.
+ * @param g The green component of the color.
+ * @param b The blue component of the color.
+ * @param a The alpha component of the color.
+ * @return The blend constants.
+ */
+BlendConstants blendConstants(std::uint8_t r, std::uint8_t g, std::uint8_t b, std::uint8_t a);
+
+/**
+ * @brief blendConstants Gets the constants for blending a color the way geometrize::drawLines does, with pixels that may be known to be opaque.
+ * @param r The red component of the color.
+ * @param g The green component of the color.
+ * @param b The blue component of the color.
+ * @param a The alpha component of the color.
+ * @param opaque Whether every pixel the color is blended with is opaque.
+ * @return The blend constants.
+ */
+BlendConstants blendConstants(std::uint8_t r, std::uint8_t g, std::uint8_t b, std::uint8_t a, bool opaque);
+
+/**
+ * @brief grayBlendConstants Gets the constants for blending a gray color with GRAY8 pixels, which blends every byte like the red channel of blendConstants(gray, gray, gray, a).
+ * @param gray The gray value of the color.
+ * @param a The alpha component of the color.
+ * @return The blend constants, for use with the grayscale kernels only.
+ */
+BlendConstants grayBlendConstants(std::uint8_t gray, std::uint8_t a);
+
+/**
+ * @brief sumChannels Adds up each channel of a run of pixels.
+ * @param pixels The pixels.
+ * @param count The number of pixels.
+ * @param totals The totals for each channel, which the sums are added to.
+ */
+void sumChannels(const std::uint8_t* pixels, std::size_t count, std::uint64_t (&totals)[4]);
+
+/**
+ * @brief squaredDifference Calculates the sum of the squared differences between the channels of two runs of pixels.
+ * @param first The first pixels.
+ * @param second The second pixels.
+ * @param count The number of pixels.
+ * @return The sum of the squared differences.
+ */
+std::uint64_t squaredDifference(const std::uint8_t* first, const std::uint8_t* second, std::size_t count);
+
+/**
+ * @brief difference Calculates how much the squared error against a target changes when a run of pixels changes.
+ * @param target The target pixels.
+ * @param before The pixels before the change.
+ * @param after The pixels after the change.
+ * @param count The number of pixels.
+ * @return The sum of the squared differences between the target and after channels, minus that between the target and before channels.
+ */
+std::int64_t difference(const std::uint8_t* target, const std::uint8_t* before, const std::uint8_t* after, std::size_t count);
+
+/**
+ * @brief differenceBlended Calculates how much the squared error against a target changes when a run of pixels is blended with a color, without blending them.
+ * @param target The target pixels.
+ * @param before The pixels before blending.
+ * @param count The number of pixels.
+ * @param blend The constants for blending the color, see blendConstants.
+ * @return The sum of the squared differences between the target and blended channels, minus that between the target and before channels.
+ */
+std::int64_t differenceBlended(const std::uint8_t* target, const std::uint8_t* before, std::size_t count, const geometrize::kernels::BlendConstants& blend);
+
+/**
+ * @brief blend Blends a run of pixels with a color, in place.
+ * @param pixels The pixels.
+ * @param count The number of pixels.
+ * @param blend The constants for blending the color, see blendConstants.
+ */
+void blend(std::uint8_t* pixels, std::size_t count, const geometrize::kernels::BlendConstants& blend);
+
+/**
+ * @brief sumGray Adds up a run of gray pixels.
+ * @param pixels The pixels.
+ * @param count The number of pixels.
+ * @return The sum of the pixels.
+ */
+std::uint64_t sumGray(const std::uint8_t* pixels, std::size_t count);
+
+/**
+ * @brief squaredDifferenceGray Calculates the sum of the squared differences between two runs of gray pixels.
+ * @param first The first pixels.
+ * @param second The second pixels.
+ * @param count The number of pixels.
+ * @return The sum of the squared differences.
+ */
+std::uint64_t squaredDifferenceGray(const std::uint8_t* first, const std::uint8_t* second, std::size_t count);
+
+/**
+ * @brief differenceGray Calculates how much the squared error against a target changes when a run of gray pixels changes.
+ * @param target The target pixels.
+ * @param before The pixels before the change.
+ * @param after The pixels after the change.
+ * @param count The number of pixels.
+ * @return The sum of the squared differences between the target and after pixels, minus that between the target and before pixels.
+ */
+std::int64_t differenceGray(const std::uint8_t* target, const std::uint8_t* before, const std::uint8_t* after, std::size_t count);
+
+/**
+ * @brief differenceBlendedGray Calculates how much the squared error against a target changes when a run of gray pixels is blended with a gray color, without blending them.
+ * @param target The target pixels.
+ * @param before The pixels before blending.
+ * @param count The number of pixels.
+ * @param blend The constants for blending the color, see grayBlendConstants.
+ * @return The sum of the squared differences between the target and blended pixels, minus that between the target and before pixels.
+ */
+std::int64_t differenceBlendedGray(const std::uint8_t* target, const std::uint8_t* before, std::size_t count, const geometrize::kernels::BlendConstants& blend);
+
+/**
+ * @brief blendGray Blends a run of gray pixels with a gray color, in place.
+ * @param pixels The pixels.
+ * @param count The number of pixels.
+ * @param blend The constants for blending the color, see grayBlendConstants.
+ */
+void blendGray(std::uint8_t* pixels, std::size_t count, const geometrize::kernels::BlendConstants& blend);
+
+}
+
+}
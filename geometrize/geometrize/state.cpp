@@ -1,5 +1,6 @@
 #include "state.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <vector>
@@ -8,6 +9,8 @@
 #include "bitmap/bitmap.h"
 #include "core.h"
 #include "model.h"
+#include "momenttables.h"
+#include "shape/rectangle.h"
 #include "shape/shape.h"
 #include "shape/shapefactory.h"
 #include "shape/shapetypes.h"
@@ -27,7 +30,13 @@ State& State::operator=(const geometrize::State& other)
     if(this != &other) {
         m_score = other.m_score;
         m_alpha = other.m_alpha;
-        m_shape = other.m_shape->clone();
+
+        // Copy into the existing shape when nothing else refers to it, rather than allocating a new one, unless the shape cannot be copied in place
+        const bool assigned{m_shape && m_shape.use_count() == 1 && m_shape->getType() == other.m_shape->getType() && &m_shape->m_model == &other.m_shape->m_model
+                && m_shape->assign(*other.m_shape)};
+        if(!assigned) {
+            m_shape = other.m_shape->clone();
+        }
     }
     return *this;
 }
@@ -36,19 +45,41 @@ State::State(const geometrize::State& other) : m_score{other.m_score}, m_alpha{o
 {
 }
 
-float State::calculateEnergy(const geometrize::Bitmap& target, const geometrize::Bitmap& current, geometrize::Bitmap& buffer, const float lastScore)
+float State::calculateEnergy(const geometrize::Bitmap& target, const geometrize::Bitmap& current, const float lastScore)
 {
     assert(m_score < 0 && "Score was not reset");
-    m_score = geometrize::core::energy(m_shape->rasterize(), m_alpha, target, current, buffer, lastScore);
+    const geometrize::MomentTables* moments{m_shape->m_model.getMomentTables()};
+    if(moments && m_shape->getType() == geometrize::ShapeTypes::RECTANGLE) {
+        // Rectangles are axis-aligned boxes, so their moments can be looked up directly without rasterizing them
+        // Note the bounds match Rectangle::rasterize, which excludes the bottom row
+        const geometrize::Rectangle& rect{static_cast<const geometrize::Rectangle&>(*m_shape)};
+        const geometrize::Moments sum(moments->getMoments(
+                (std::min)(rect.m_x1, rect.m_x2), (std::min)(rect.m_y1, rect.m_y2),
+                (std::max)(rect.m_x1, rect.m_x2), (std::max)(rect.m_y1, rect.m_y2) - 1));
+        m_score = geometrize::core::energy(sum, m_alpha, moments->getWidth(), moments->getHeight(), lastScore);
+    } else {
+        // Rasterize into a buffer that each thread reuses, so scoring does not allocate once the buffer has grown large enough
+        thread_local static std::vector<geometrize::Scanline> lines;
+        m_shape->rasterize(lines);
+        if(moments) {
+            m_score = geometrize::core::energy(lines, m_alpha, *moments, lastScore);
+        } else {
+            m_score = geometrize::core::energy(lines, m_alpha, target, current, lastScore, m_shape->m_model.isOpaque());
+        }
+    }
     return m_score;
 }
 
-geometrize::State State::mutate()
+void State::mutate()
 {
-    geometrize::State oldState(*this);
     m_shape->mutate();
     m_score = -1;
-    return oldState;
+}
+
+void State::mutate(geometrize::ShapeUndo& undo)
+{
+    m_shape->mutate(undo);
+    m_score = -1;
 }
 
 }
@@ -10,6 +10,7 @@ namespace geometrize
 class Bitmap;
 class Model;
 class Shape;
+class ShapeUndo;
 }
 
 namespace geometrize
@@ -41,13 +42,19 @@ public:
      * The lower the energy, the better. The score is cached, set it to < 0 to recalculate it.
      * @return The energy measure.
      */
-    float calculateEnergy(const geometrize::Bitmap& target, const geometrize::Bitmap& current, geometrize::Bitmap& buffer, float lastScore);
+    float calculateEnergy(const geometrize::Bitmap& target, const geometrize::Bitmap& current, float lastScore);
 
     /**
      * @brief mutate Modifies the current state in a random fashion.
-     * @return The old state, useful for undoing the mutation or keeping track of previous states.
+     * To be able to undo the mutation, assign the state to another one first - assigning between states of the same shape type does not allocate.
      */
-    geometrize::State mutate();
+    void mutate();
+
+    /**
+     * @brief mutate Modifies the current state in a random fashion, recording what changed so the mutation can be undone without a copy of the state.
+     * @param undo The record of the changes made. If it is complete, ShapeUndo::revert restores the shape (the score must be restored separately).
+     */
+    void mutate(geometrize::ShapeUndo& undo);
 
     float m_score; ///< The score of the state, a measure of the improvement applying the state to the current bitmap will have.
     std::uint8_t m_alpha; ///< The alpha of the shape.
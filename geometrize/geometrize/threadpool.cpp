@@ -0,0 +1,131 @@
+#include "threadpool.h"
+
+#include <cassert>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace geometrize
+{
+
+ThreadPool::ThreadPool(std::uint32_t threadCount) :
+    m_threadCount{0},
+    m_task{nullptr},
+    m_taskCount{0},
+    m_nextTask{0},
+    m_pendingTasks{0},
+    m_stopping{false}
+{
+    if(threadCount == 0) {
+        threadCount = std::thread::hardware_concurrency();
+        if(threadCount == 0) {
+            assert(0 && "Failed to get the number of concurrent threads supported by the implementation");
+            threadCount = 1;
+        }
+    }
+
+    m_threadCount = threadCount;
+    m_threads.reserve(threadCount);
+    for(std::uint32_t i = 0; i < threadCount; i++) {
+        m_threads.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    shutdown();
+}
+
+void ThreadPool::run(const std::uint32_t taskCount, const std::function<void(std::uint32_t, std::uint32_t)>& task)
+{
+    if(taskCount == 0) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> runLock(m_runMutex);
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    if(m_stopping) {
+        lock.unlock();
+        for(std::uint32_t i = 0; i < taskCount; i++) {
+            task(i, 0);
+        }
+        return;
+    }
+
+    m_task = &task;
+    m_taskCount = taskCount;
+    m_nextTask = 0;
+    m_pendingTasks = taskCount;
+    m_exception = nullptr;
+    m_workCondition.notify_all();
+
+    m_doneCondition.wait(lock, [this]() { return m_pendingTasks == 0; });
+
+    m_task = nullptr;
+    m_taskCount = 0;
+    m_nextTask = 0;
+
+    if(m_exception) {
+        std::exception_ptr exception{m_exception};
+        m_exception = nullptr;
+        std::rethrow_exception(exception);
+    }
+}
+
+void ThreadPool::shutdown()
+{
+    {
+        std::lock_guard<std::mutex> runLock(m_runMutex); // Let any batch that is running finish first
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_workCondition.notify_all();
+
+    for(std::thread& thread : m_threads) {
+        if(thread.joinable()) {
+            thread.join();
+        }
+    }
+}
+
+std::uint32_t ThreadPool::getThreadCount() const
+{
+    return m_threadCount;
+}
+
+void ThreadPool::workerLoop(const std::uint32_t worker)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while(true) {
+        m_workCondition.wait(lock, [this]() { return m_stopping || m_nextTask < m_taskCount; });
+        if(m_stopping) {
+            return;
+        }
+
+        const std::uint32_t task{m_nextTask++};
+        const std::function<void(std::uint32_t, std::uint32_t)>& func(*m_task);
+        lock.unlock();
+
+        std::exception_ptr exception{nullptr};
+        try {
+            func(task, worker);
+        } catch(...) {
+            exception = std::current_exception();
+        }
+
+        lock.lock();
+        if(exception && !m_exception) {
+            m_exception = exception;
+        }
+        m_pendingTasks--;
+        if(m_pendingTasks == 0) {
+            m_doneCondition.notify_all();
+        }
+    }
+}
+
+}
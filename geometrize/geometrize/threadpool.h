@@ -0,0 +1,73 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace geometrize
+{
+
+/**
+ * @brief The ThreadPool class keeps a fixed set of worker threads alive, so that repeated batches of work do not pay for creating and joining threads.
+ * Work is submitted as a batch of numbered tasks, which the workers take from a shared queue until the batch is done.
+ * @author Sam Twidale (http://samcodes.co.uk/)
+ */
+class ThreadPool
+{
+public:
+    /**
+     * @brief ThreadPool Creates a thread pool and starts its worker threads.
+     * @param threadCount The number of worker threads. If 0, the number of concurrent threads supported by the implementation is used.
+     */
+    explicit ThreadPool(std::uint32_t threadCount);
+
+    /**
+     * @brief ~ThreadPool Shuts down the pool, waiting for the worker threads to finish.
+     */
+    ~ThreadPool();
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ThreadPool(const ThreadPool&) = delete;
+
+    /**
+     * @brief run Runs a batch of tasks on the worker threads, and waits until all of them have finished.
+     * Tasks are started in order, but may finish in any order. Batches submitted from different threads are run one after another.
+     * If a task throws, the batch still runs to completion and then the first exception thrown is rethrown here.
+     * If the pool has been shut down, the tasks are run on the calling thread instead.
+     * @param taskCount The number of tasks to run.
+     * @param task The function to run for each task. It is passed the task index (0 to taskCount - 1) and the index of the worker running it (0 to getThreadCount() - 1).
+     */
+    void run(std::uint32_t taskCount, const std::function<void(std::uint32_t task, std::uint32_t worker)>& task);
+
+    /**
+     * @brief shutdown Stops the worker threads once they have finished their current work, and waits for them to exit. Safe to call more than once.
+     */
+    void shutdown();
+
+    /**
+     * @brief getThreadCount Gets the number of worker threads in the pool.
+     * @return The number of worker threads.
+     */
+    std::uint32_t getThreadCount() const;
+
+private:
+    void workerLoop(std::uint32_t worker);
+
+    std::vector<std::thread> m_threads; ///< The worker threads.
+    std::uint32_t m_threadCount; ///< The number of worker threads the pool was created with.
+    std::mutex m_runMutex; ///< Held for the duration of a batch, so only one batch runs at a time.
+    std::mutex m_mutex; ///< Guards the batch state below.
+    std::condition_variable m_workCondition; ///< Signalled when a batch starts, or the pool is shutting down.
+    std::condition_variable m_doneCondition; ///< Signalled when the last task in a batch finishes.
+    const std::function<void(std::uint32_t, std::uint32_t)>* m_task; ///< The function for the current batch.
+    std::uint32_t m_taskCount; ///< The number of tasks in the current batch.
+    std::uint32_t m_nextTask; ///< The index of the next task in the current batch to hand out.
+    std::uint32_t m_pendingTasks; ///< The number of tasks in the current batch that have not finished yet.
+    std::exception_ptr m_exception; ///< The first exception thrown by a task in the current batch.
+    bool m_stopping; ///< Whether the pool is shutting down.
+};
+
+}
@@ -0,0 +1,86 @@
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "geometrize/bitmap/bitmap.h"
+#include "geometrize/bitmap/pixelformat.h"
+#include "geometrize/bitmap/rgba.h"
+#include "geometrize/exporter/bitmapexporter.h"
+#include "testing.h"
+
+namespace
+{
+
+std::uint32_t readUint32(const std::string& data, const std::size_t offset)
+{
+    std::uint32_t value{0};
+    for(std::size_t i = 0; i < 4U; i++) {
+        value |= static_cast<std::uint32_t>(static_cast<std::uint8_t>(data[offset + i])) << (8U * i);
+    }
+    return value;
+}
+
+}
+
+GEOMETRIZE_TEST(bitmapFileSizesOfSmallImages)
+{
+    const geometrize::exporter::BitmapFileSizes rgb{geometrize::exporter::getBitmapFileSizes(3U, 2U, geometrize::PixelFormat::RGBA8888)};
+    GEOMETRIZE_CHECK(rgb.rowBytes == 9U);
+    GEOMETRIZE_CHECK(rgb.padding == 3U);
+    GEOMETRIZE_CHECK(rgb.dataOffset == 54U);
+    GEOMETRIZE_CHECK(rgb.imageSize == 24U);
+    GEOMETRIZE_CHECK(rgb.fileSize == 78U);
+
+    const geometrize::exporter::BitmapFileSizes gray{geometrize::exporter::getBitmapFileSizes(3U, 2U, geometrize::PixelFormat::GRAY8)};
+    GEOMETRIZE_CHECK(gray.rowBytes == 3U);
+    GEOMETRIZE_CHECK(gray.padding == 1U);
+    GEOMETRIZE_CHECK(gray.dataOffset == 54U + 1024U);
+    GEOMETRIZE_CHECK(gray.imageSize == 8U);
+    GEOMETRIZE_CHECK(gray.fileSize == 1086U);
+
+    // The exported headers hold the same sizes, and the file is as long as they say
+    for(const geometrize::PixelFormat format : {geometrize::PixelFormat::RGBA8888, geometrize::PixelFormat::GRAY8}) {
+        const geometrize::Bitmap bitmap(3U, 2U, geometrize::rgba{1, 2, 3, 255}, format);
+        const std::string file{geometrize::exporter::exportBMP(bitmap)};
+        const geometrize::exporter::BitmapFileSizes sizes{geometrize::exporter::getBitmapFileSizes(3U, 2U, format)};
+        GEOMETRIZE_CHECK(file.size() == sizes.fileSize);
+        GEOMETRIZE_CHECK(readUint32(file, 2U) == sizes.fileSize);
+        GEOMETRIZE_CHECK(readUint32(file, 10U) == sizes.dataOffset);
+        GEOMETRIZE_CHECK(readUint32(file, 34U) == sizes.imageSize);
+    }
+}
+
+GEOMETRIZE_TEST(bitmapFileSizesOfImagesOver4GiB)
+{
+    // The largest 8-bit image whose file fits in 4 GiB keeps its sizes
+    const geometrize::exporter::BitmapFileSizes fits{geometrize::exporter::getBitmapFileSizes(65536U, 65535U, geometrize::PixelFormat::GRAY8)};
+    GEOMETRIZE_CHECK(fits.padding == 0U);
+    GEOMETRIZE_CHECK(fits.imageSize == 65536U * 65535U);
+    GEOMETRIZE_CHECK(fits.fileSize == 65536U * 65535U + 1078U);
+
+    // One more row and the sizes no longer fit in the 32-bit header fields, so they are zeroed
+    const geometrize::exporter::BitmapFileSizes tooLarge{geometrize::exporter::getBitmapFileSizes(65536U, 65536U, geometrize::PixelFormat::GRAY8)};
+    GEOMETRIZE_CHECK(tooLarge.imageSize == 0U);
+    GEOMETRIZE_CHECK(tooLarge.fileSize == 0U);
+    GEOMETRIZE_CHECK(tooLarge.dataOffset == 1078U);
+
+    // Widths whose row size does not fit in 32 bits, the padding still comes from the full row size
+    const geometrize::exporter::BitmapFileSizes wide{geometrize::exporter::getBitmapFileSizes(UINT32_MAX, 2U, geometrize::PixelFormat::RGBA8888)};
+    GEOMETRIZE_CHECK(wide.rowBytes == 3ULL * UINT32_MAX);
+    GEOMETRIZE_CHECK(wide.padding == 3U);
+    GEOMETRIZE_CHECK(wide.imageSize == 0U);
+    GEOMETRIZE_CHECK(wide.fileSize == 0U);
+
+    const geometrize::exporter::BitmapFileSizes wideGray{geometrize::exporter::getBitmapFileSizes(UINT32_MAX - 1U, 1U, geometrize::PixelFormat::GRAY8)};
+    GEOMETRIZE_CHECK(wideGray.rowBytes == UINT32_MAX - 1U);
+    GEOMETRIZE_CHECK(wideGray.padding == 2U);
+    GEOMETRIZE_CHECK(wideGray.imageSize == 0U);
+    GEOMETRIZE_CHECK(wideGray.fileSize == 0U);
+
+    // Widths and heights whose product overflows 32 bits, though each fits easily
+    const geometrize::exporter::BitmapFileSizes large{geometrize::exporter::getBitmapFileSizes(70001U, 70000U, geometrize::PixelFormat::RGBA8888)};
+    GEOMETRIZE_CHECK(large.rowBytes == 210003U);
+    GEOMETRIZE_CHECK(large.padding == 1U);
+    GEOMETRIZE_CHECK(large.imageSize == 0U);
+    GEOMETRIZE_CHECK(large.fileSize == 0U);
+}
@@ -0,0 +1,54 @@
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "geometrize/bitmap/bitmap.h"
+#include "geometrize/bitmap/bitmapview.h"
+#include "geometrize/bitmap/pixelformat.h"
+#include "geometrize/bitmap/rgba.h"
+#include "testing.h"
+
+namespace
+{
+
+// Sizes over 4 GiB can only be checked where std::size_t is 64 bits
+const bool sizeIs64Bit{sizeof(std::size_t) >= sizeof(std::uint64_t)};
+
+}
+
+GEOMETRIZE_TEST(pixelIndexDoesNotOverflowForLargeBitmaps)
+{
+    GEOMETRIZE_CHECK(geometrize::Bitmap::getPixelIndex(3U, 2U, 1U) == 5U);
+    if(!sizeIs64Bit) {
+        return;
+    }
+
+    // Bitmaps whose width times height does not fit in 32 bits
+    GEOMETRIZE_CHECK(geometrize::Bitmap::getPixelIndex(100000U, 7U, 50000U) == static_cast<std::size_t>(100000ULL * 50000ULL + 7ULL));
+    GEOMETRIZE_CHECK(geometrize::Bitmap::getPixelIndex(65536U, 0U, 65536U) == static_cast<std::size_t>(1ULL << 32));
+    GEOMETRIZE_CHECK(geometrize::Bitmap::getPixelIndex(UINT32_MAX, UINT32_MAX - 1U, UINT32_MAX - 1U) == static_cast<std::size_t>(0xFFFFFFFFULL * 0xFFFFFFFEULL + 0xFFFFFFFEULL));
+}
+
+GEOMETRIZE_TEST(bitmapViewRowOffsetsDoNotOverflowForLargeStrides)
+{
+    const std::vector<std::uint8_t> data{10, 20, 30, 40, 50, 60, 70, 80};
+
+    const geometrize::BitmapView view(data.data(), 2U, 70000U, 1U << 20, geometrize::PixelFormat::RGBA8888);
+    GEOMETRIZE_CHECK(view.getRowOffset(3U) == static_cast<std::size_t>(3U << 20));
+    if(!sizeIs64Bit) {
+        return;
+    }
+    GEOMETRIZE_CHECK(view.getRowOffset(65536U) == static_cast<std::size_t>(1ULL << 36));
+    GEOMETRIZE_CHECK(view.getRowOffset(69999U) == static_cast<std::size_t>(69999ULL << 20));
+
+    // A single row view can have a stride over 4 GiB without needing that much data, and still converts correctly
+    const std::size_t largeStride{static_cast<std::size_t>((1ULL << 33) + 8ULL)};
+    const geometrize::BitmapView row(data.data(), 2U, 1U, largeStride, geometrize::PixelFormat::BGRA8888);
+    GEOMETRIZE_CHECK(row.getStride() == largeStride);
+    const geometrize::Bitmap bitmap(row);
+    GEOMETRIZE_CHECK(bitmap.getWidth() == 2U && bitmap.getHeight() == 1U);
+    const geometrize::rgba first(bitmap.getPixel(0U, 0U));
+    const geometrize::rgba second(bitmap.getPixel(1U, 0U));
+    GEOMETRIZE_CHECK(first.r == 30 && first.g == 20 && first.b == 10 && first.a == 40);
+    GEOMETRIZE_CHECK(second.r == 70 && second.g == 60 && second.b == 50 && second.a == 80);
+}
@@ -0,0 +1,48 @@
+#include <cstddef>
+#include <cstdio>
+#include <vector>
+
+#include "testing.h"
+
+namespace
+{
+
+std::size_t failureCount{0};
+
+}
+
+namespace geometrize
+{
+
+namespace tests
+{
+
+std::vector<geometrize::tests::Test>& getTests()
+{
+    static std::vector<geometrize::tests::Test> tests;
+    return tests;
+}
+
+void fail(const char* file, const int line, const char* condition)
+{
+    // Report the first few failures of a run in full, a broken kernel can fail thousands of checks
+    if(failureCount < 100U) {
+        std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, condition);
+    }
+    failureCount++;
+}
+
+}
+
+}
+
+int main()
+{
+    for(const geometrize::tests::Test& test : geometrize::tests::getTests()) {
+        const std::size_t failuresBefore{failureCount};
+        test.run();
+        std::printf("%s %s\n", failureCount == failuresBefore ? "PASS" : "FAIL", test.name);
+    }
+    std::printf("%zu tests, %zu failed checks\n", geometrize::tests::getTests().size(), failureCount);
+    return failureCount == 0 ? 0 : 1;
+}
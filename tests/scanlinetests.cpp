@@ -0,0 +1,106 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "geometrize/rasterizer/scanline.h"
+#include "testing.h"
+
+namespace
+{
+
+typedef std::set<std::pair<std::int32_t, std::int32_t>> PixelSet;
+
+PixelSet getPixels(const std::vector<geometrize::Scanline>& lines)
+{
+    PixelSet pixels;
+    for(const geometrize::Scanline& line : lines) {
+        for(std::int32_t x = line.x1; x <= line.x2; x++) {
+            pixels.insert(std::make_pair(line.y, x));
+        }
+    }
+    return pixels;
+}
+
+std::size_t getPixelCount(const std::vector<geometrize::Scanline>& lines)
+{
+    std::size_t count{0};
+    for(const geometrize::Scanline& line : lines) {
+        count += static_cast<std::size_t>(line.x2 - line.x1 + 1);
+    }
+    return count;
+}
+
+// Makes overlapping, touching and duplicate scanlines in random order, some of them partly or entirely outside of a 40x30 area
+std::vector<geometrize::Scanline> makeRandomScanlines(std::mt19937& rng)
+{
+    std::vector<geometrize::Scanline> lines;
+    const std::size_t count{rng() % 60U};
+    for(std::size_t i = 0; i < count; i++) {
+        const std::int32_t y{static_cast<std::int32_t>(rng() % 40U) - 5};
+        const std::int32_t x1{static_cast<std::int32_t>(rng() % 60U) - 10};
+        const std::int32_t x2{x1 + static_cast<std::int32_t>(rng() % 12U)};
+        lines.push_back(geometrize::Scanline(y, x1, x2));
+        if(rng() % 8U == 0) {
+            lines.push_back(lines.back());
+        }
+    }
+    std::shuffle(lines.begin(), lines.end(), rng);
+    return lines;
+}
+
+}
+
+GEOMETRIZE_TEST(coalesceKeepsThePixelSet)
+{
+    std::mt19937 rng(7);
+    for(std::size_t repeat = 0; repeat < 2000U; repeat++) {
+        std::vector<geometrize::Scanline> lines{makeRandomScanlines(rng)};
+
+        // Also cover the inputs coalesce handles without sorting, scanlines that are already in order or in reverse order
+        if(repeat % 3U == 1U) {
+            geometrize::Scanline::coalesce(lines);
+        } else if(repeat % 3U == 2U) {
+            geometrize::Scanline::coalesce(lines);
+            std::reverse(lines.begin(), lines.end());
+        }
+
+        const PixelSet before{getPixels(lines)};
+        geometrize::Scanline::coalesce(lines);
+        GEOMETRIZE_CHECK(getPixels(lines) == before);
+
+        // The result is sorted by row and then by column, and scanlines on the same row neither overlap nor touch, so every pixel is covered once
+        GEOMETRIZE_CHECK(getPixelCount(lines) == before.size());
+        for(std::size_t i = 1; i < lines.size(); i++) {
+            const geometrize::Scanline& previous(lines[i - 1U]);
+            const geometrize::Scanline& line(lines[i]);
+            GEOMETRIZE_CHECK(previous.y < line.y || (previous.y == line.y && previous.x2 + 1 < line.x1));
+        }
+    }
+}
+
+GEOMETRIZE_TEST(trimKeepsThePixelsInBounds)
+{
+    const std::int32_t w{40};
+    const std::int32_t h{30};
+    std::mt19937 rng(11);
+    for(std::size_t repeat = 0; repeat < 2000U; repeat++) {
+        std::vector<geometrize::Scanline> lines{makeRandomScanlines(rng)};
+        PixelSet inBounds;
+        for(const std::pair<std::int32_t, std::int32_t>& pixel : getPixels(lines)) {
+            if(pixel.first >= 0 && pixel.first < h && pixel.second >= 0 && pixel.second < w) {
+                inBounds.insert(pixel);
+            }
+        }
+
+        const std::vector<geometrize::Scanline> trimmed{geometrize::Scanline::trim(lines, w, h)};
+        GEOMETRIZE_CHECK(getPixels(trimmed) == inBounds);
+
+        // Trimming in place gives the same scanlines in the same order
+        geometrize::Scanline::trimInPlace(lines, w, h);
+        GEOMETRIZE_CHECK(lines == trimmed);
+    }
+}
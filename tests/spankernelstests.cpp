@@ -0,0 +1,189 @@
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "geometrize/spankernels.h"
+#include "testing.h"
+
+namespace
+{
+
+using geometrize::kernels::BlendConstants;
+using geometrize::kernels::InstructionSet;
+
+// Run lengths 0 to 67 cover every tail of the 16 and 32 pixel vector loops, the long run crosses the vector kernels' 8192 pixel accumulator flush several times
+const std::size_t maxShortCount{67};
+const std::size_t longCount{3 * 8192 + 13};
+const std::size_t maxOffset{7};
+const std::size_t extremeCount{1U << 20};
+
+const InstructionSet instructionSets[]{InstructionSet::SCALAR, InstructionSet::SSE41, InstructionSet::AVX2};
+
+// The blend geometrize::drawLines is defined by, written out independently of the kernels
+std::int32_t referenceBlend(const std::int32_t before, const std::uint32_t value, const std::uint32_t alpha, const bool alphaChannel)
+{
+    const std::uint32_t m{65535};
+    const std::uint32_t sa{alpha * 257U};
+    const std::uint32_t s{alphaChannel ? sa : value * 257U * alpha / 255U};
+    const std::uint32_t inverse{(m - sa) * 257U};
+    return static_cast<std::int32_t>(((static_cast<std::uint64_t>(before) * inverse + static_cast<std::uint64_t>(s) * m) / m) >> 8);
+}
+
+struct Color
+{
+    std::uint8_t channels[4];
+};
+
+void fillRandom(std::vector<std::uint8_t>& bytes, std::mt19937& rng)
+{
+    for(std::uint8_t& byte : bytes) {
+        byte = static_cast<std::uint8_t>(rng());
+    }
+}
+
+// Makes the alpha channel of the pixels from the given byte offset opaque
+void makeOpaque(std::vector<std::uint8_t>& pixels, const std::size_t offset)
+{
+    for(std::size_t i = offset + 3U; i < pixels.size(); i += 4U) {
+        pixels[i] = UINT8_MAX;
+    }
+}
+
+// Checks every kernel against the reference on one run of pixels, the pixels are used from the given byte offset so loads are misaligned
+void checkRun(
+        const std::vector<std::uint8_t>& target,
+        const std::vector<std::uint8_t>& before,
+        const std::vector<std::uint8_t>& after,
+        const std::size_t offset,
+        const std::size_t count,
+        const Color color,
+        const bool opaque)
+{
+    const std::uint8_t* t{target.data() + offset};
+    const std::uint8_t* b{before.data() + offset};
+    const std::uint8_t* a{after.data() + offset};
+    const std::uint8_t* c{color.channels};
+    const BlendConstants blend{geometrize::kernels::blendConstants(c[0], c[1], c[2], c[3], opaque)};
+    const BlendConstants grayBlend{geometrize::kernels::grayBlendConstants(c[0], c[3])};
+
+    // RGBA8888 kernels
+    std::uint64_t sums[4]{0, 0, 0, 0};
+    std::uint64_t squared{0};
+    std::int64_t changed{0};
+    std::int64_t blended{0};
+    std::vector<std::uint8_t> drawn(b, b + count * 4U);
+    for(std::size_t i = 0; i < count * 4U; i++) {
+        const std::int32_t n{referenceBlend(b[i], c[i & 3U], c[3], (i & 3U) == 3U)};
+        sums[i & 3U] += t[i];
+        squared += static_cast<std::uint64_t>((t[i] - a[i]) * (t[i] - a[i]));
+        changed += (t[i] - a[i]) * (t[i] - a[i]) - (t[i] - b[i]) * (t[i] - b[i]);
+        blended += (t[i] - n) * (t[i] - n) - (t[i] - b[i]) * (t[i] - b[i]);
+        drawn[i] = static_cast<std::uint8_t>(n);
+    }
+
+    std::uint64_t totals[4]{1, 2, 3, 4};
+    geometrize::kernels::sumChannels(t, count, totals);
+    for(std::size_t i = 0; i < 4U; i++) {
+        GEOMETRIZE_CHECK(totals[i] == sums[i] + i + 1U);
+    }
+    GEOMETRIZE_CHECK(geometrize::kernels::squaredDifference(t, a, count) == squared);
+    GEOMETRIZE_CHECK(geometrize::kernels::difference(t, b, a, count) == changed);
+    GEOMETRIZE_CHECK(geometrize::kernels::differenceBlended(t, b, count, blend) == blended);
+    std::vector<std::uint8_t> pixels(b, b + count * 4U);
+    geometrize::kernels::blend(pixels.data(), count, blend);
+    GEOMETRIZE_CHECK(pixels == drawn);
+
+    // GRAY8 kernels, on the same bytes taken as gray pixels
+    const std::size_t grayCount{count * 4U};
+    std::uint64_t graySum{0};
+    std::int64_t grayBlended{0};
+    std::vector<std::uint8_t> grayDrawn(b, b + grayCount);
+    for(std::size_t i = 0; i < grayCount; i++) {
+        const std::int32_t n{referenceBlend(b[i], c[0], c[3], false)};
+        graySum += t[i];
+        grayBlended += (t[i] - n) * (t[i] - n) - (t[i] - b[i]) * (t[i] - b[i]);
+        grayDrawn[i] = static_cast<std::uint8_t>(n);
+    }
+    GEOMETRIZE_CHECK(geometrize::kernels::sumGray(t, grayCount) == graySum);
+    GEOMETRIZE_CHECK(geometrize::kernels::squaredDifferenceGray(t, a, grayCount) == squared);
+    GEOMETRIZE_CHECK(geometrize::kernels::differenceGray(t, b, a, grayCount) == changed);
+    GEOMETRIZE_CHECK(geometrize::kernels::differenceBlendedGray(t, b, grayCount, grayBlend) == grayBlended);
+    std::vector<std::uint8_t> grayPixels(b, b + grayCount);
+    geometrize::kernels::blendGray(grayPixels.data(), grayCount, grayBlend);
+    GEOMETRIZE_CHECK(grayPixels == grayDrawn);
+}
+
+// Runs a check with each version of the kernels that the processor supports, then restores the version that was in use
+template<typename F>
+void forEachInstructionSet(F&& check)
+{
+    const InstructionSet original{geometrize::kernels::getInstructionSet()};
+    for(const InstructionSet instructionSet : instructionSets) {
+        geometrize::kernels::setInstructionSet(instructionSet);
+        if(geometrize::kernels::getInstructionSet() == instructionSet) {
+            check();
+        }
+    }
+    geometrize::kernels::setInstructionSet(original);
+}
+
+}
+
+GEOMETRIZE_TEST(spanKernelsMatchReferenceOnRandomRuns)
+{
+    forEachInstructionSet([]() {
+        std::mt19937 rng(2017);
+        const std::size_t size{(maxShortCount + maxOffset + 1U) * 4U};
+        std::vector<std::uint8_t> target(size);
+        std::vector<std::uint8_t> before(size);
+        std::vector<std::uint8_t> after(size);
+
+        for(std::size_t count = 0; count <= maxShortCount; count++) {
+            for(std::size_t repeat = 0; repeat < 8U; repeat++) {
+                fillRandom(target, rng);
+                fillRandom(before, rng);
+                fillRandom(after, rng);
+                const std::size_t offset{rng() % (maxOffset * 4U + 1U)};
+                const bool opaque{repeat % 2U == 1U};
+                if(opaque) {
+                    makeOpaque(before, offset);
+                }
+
+                // Fully transparent and fully opaque colors are the edge cases of the blend
+                Color color{{static_cast<std::uint8_t>(rng()), static_cast<std::uint8_t>(rng()), static_cast<std::uint8_t>(rng()), static_cast<std::uint8_t>(rng())}};
+                if(repeat == 2U) {
+                    color.channels[3] = 0;
+                } else if(repeat == 3U) {
+                    color.channels[3] = UINT8_MAX;
+                }
+                checkRun(target, before, after, offset, count, color, opaque);
+            }
+        }
+
+        const std::size_t longSize{(longCount + 1U) * 4U};
+        target.resize(longSize);
+        before.resize(longSize);
+        after.resize(longSize);
+        fillRandom(target, rng);
+        fillRandom(before, rng);
+        fillRandom(after, rng);
+        checkRun(target, before, after, 1U, longCount, Color{{12, 200, 99, 140}}, false);
+        makeOpaque(before, 3U);
+        checkRun(target, before, after, 3U, longCount, Color{{250, 1, 128, 77}}, true);
+    });
+}
+
+GEOMETRIZE_TEST(spanKernelsMatchReferenceOnExtremeRuns)
+{
+    // Long runs of the largest differences and sums, which overflow the vector kernels' 32-bit accumulators unless they are flushed often enough
+    forEachInstructionSet([]() {
+        const std::size_t size{extremeCount * 4U};
+        const std::vector<std::uint8_t> zeros(size, 0);
+        const std::vector<std::uint8_t> full(size, UINT8_MAX);
+        checkRun(zeros, full, zeros, 0U, extremeCount, Color{{255, 255, 255, 255}}, true);
+        checkRun(full, zeros, full, 0U, extremeCount, Color{{0, 0, 0, 255}}, false);
+        checkRun(zeros, zeros, full, 0U, extremeCount, Color{{255, 255, 255, 255}}, false);
+        checkRun(full, full, zeros, 0U, extremeCount, Color{{0, 0, 0, 1}}, true);
+    });
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace geometrize
+{
+
+namespace tests
+{
+
+/**
+ * The tests in this directory check the library internals that the external unit tests cannot reach, or that need too much data to check there.
+ * Each test is a function declared with GEOMETRIZE_TEST, which registers it to be run by main. Failed checks are reported with GEOMETRIZE_CHECK and do not stop the test.
+ * @author Sam Twidale (http://samcodes.co.uk/)
+ */
+
+/**
+ * @brief The Test struct names a test function.
+ */
+struct Test
+{
+    const char* name; ///< The name of the test.
+    void (*run)(); ///< The test function.
+};
+
+/**
+ * @brief getTests Gets the registered tests.
+ * @return The registered tests, in the order they were registered.
+ */
+std::vector<geometrize::tests::Test>& getTests();
+
+/**
+ * @brief fail Reports a failed check.
+ * @param file The source file of the check.
+ * @param line The line of the check.
+ * @param condition The condition that did not hold.
+ */
+void fail(const char* file, int line, const char* condition);
+
+/**
+ * @brief The TestRegistrar struct registers a test when it is constructed, see GEOMETRIZE_TEST.
+ */
+struct TestRegistrar
+{
+    TestRegistrar(const char* name, void (*run)())
+    {
+        getTests().push_back(geometrize::tests::Test{name, run});
+    }
+};
+
+}
+
+}
+
+#define GEOMETRIZE_TEST(name) \
+    static void name(); \
+    static const geometrize::tests::TestRegistrar name##Registrar{#name, name}; \
+    static void name()
+
+#define GEOMETRIZE_CHECK(condition) \
+    do { \
+        if(!(condition)) { \
+            geometrize::tests::fail(__FILE__, __LINE__, #condition); \
+        } \
+    } while(false)
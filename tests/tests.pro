@@ -0,0 +1,8 @@
+TEMPLATE = app
+CONFIG += console c++11
+CONFIG -= app_bundle qt
+
+include($$PWD/../geometrize/geometrize.pri)
+
+HEADERS += $$files($$PWD/*.h)
+SOURCES += $$files($$PWD/*.cpp)